@@ -19,14 +19,27 @@ cmd_t cmd;
 
 void apInit(void)
 {
+#ifdef _USE_CRC_BENCH
+  bootCrcBench();
+#endif
+
   if (buttonGetPressed(_DEF_BUTTON1) == false)
   {
+    // 이미 확인한 이미지면 CRC 확인을 생략.
+    //
+    if (bootVerifyFw() == true && bootVerifyCache() == true)
+    {
+      bootJumpToFw();
+    }
     if (bootVerifyFw() == true && bootVerifyCrc() == true)
     {
+      bootVerifyCacheSave();
       bootJumpToFw();
     }
   }
 
+  bootInit();
+
   cmdInit(&cmd);
   cmdOpen(&cmd, _DEF_UART1, 115200);
 }
@@ -49,5 +62,7 @@ void apMain(void)
     {
       bootProcessCmd(&cmd);
     }
+
+    bootUpdate(&cmd);
   }
 }
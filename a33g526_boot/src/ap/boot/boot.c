@@ -16,9 +16,112 @@
 #define BOOT_CMD_FLASH_ERASE            0x04
 #define BOOT_CMD_FLASH_WRITE            0x05
 #define BOOT_CMD_JUMP_TO_FW             0x08
+#define BOOT_CMD_READ_CAPS              0x09
+#define BOOT_CMD_FLASH_WRITE_COMPRESSED 0x0A
+#define BOOT_CMD_DELTA_BEGIN            0x0B
+#define BOOT_CMD_DELTA_WRITE            0x0C
+#define BOOT_CMD_DELTA_END              0x0D
+#define BOOT_CMD_FLASH_READ_CRC         0x0E
+#define BOOT_CMD_SET_BAUD               0x0F
 #define BOOT_CMD_LED_CONTROL            0x10
+#define BOOT_CMD_FLASH_READ             0x11
+#define BOOT_CMD_READ_UART_STAT         0x12
 
 
+#define BOOT_WRITE_STEP_LENGTH          4     // 한번에 Write 하는 크기 (1 word)
+#define BOOT_WRITE_RX_THRESHOLD         64    // 수신 데이터가 이보다 많으면 Write 보다 수신을 먼저 처리
+#define BOOT_VERIFY_MAGIC               0x49524556    // "VERI"
+#define BOOT_VERIFY_CNT_MAX             ((1024 - 16) / 4)
+
+#define BOOT_BAUD_CONFIRM_TIME          1000  // ms, 새 속도로 패킷을 받지 못하면 이전 속도로 복귀
+
+#define BOOT_SECTOR_LENGTH              1024
+#define BOOT_STAGE_LENGTH               1024  // 압축 해제, 패치 데이터를 모아서 Write 하는 크기 (1 sector)
+
+
+typedef struct
+{
+  bool     is_busy;
+  uint8_t  err_code;      // 처음 발생한 Write 에러, 전달할 때까지 유지
+  uint32_t err_addr;      // 처음 Write 에 실패한 주소
+  uint32_t addr;
+  uint32_t length;
+  uint32_t index;
+  uint8_t  buf[CMD_MAX_DATA_LENGTH];
+} boot_write_t;
+
+typedef struct
+{
+  uint32_t magic;         // 마지막에 Write, BOOT_VERIFY_MAGIC 이면 유효
+  uint32_t fw_start;
+  uint32_t fw_length;
+  uint32_t fw_crc;
+  uint32_t boot_cnt[BOOT_VERIFY_CNT_MAX];   // CRC 를 생략하고 부팅할 때마다 앞에서부터 0 으로 Write
+} boot_verify_t;
+
+typedef struct
+{
+  bool     is_pending;    // 새 속도로 패킷을 받을 때까지 대기
+  uint32_t baud_old;
+  uint32_t pre_time;
+} boot_baud_t;
+
+typedef struct
+{
+  uint8_t  size;      // 0 이면 Window 모드 사용 안함
+  uint8_t  base;      // 다음에 받아야 할 SEQ (이전 SEQ 는 모두 받음)
+  uint32_t bits;      // base 부터 받은 SEQ 표시
+} boot_window_t;
+
+
+#if BOOT_VERIFY_PARANOID_CNT > BOOT_VERIFY_CNT_MAX
+#error "BOOT_VERIFY_PARANOID_CNT > BOOT_VERIFY_CNT_MAX"
+#endif
+
+#if BOOT_WINDOW_MAX > 32
+#error "BOOT_WINDOW_MAX > 32"
+#endif
+
+#if BOOT_WINDOW_MAX < 2
+#error "BOOT_WINDOW_MAX < 2, HW_UART_RX_BUF_LENGTH is too small for window mode"
+#endif
+
+#if BOOT_STAGE_LENGTH > CMD_MAX_DATA_LENGTH
+#error "BOOT_STAGE_LENGTH must fit in boot_write_t.buf"
+#endif
+
+typedef struct
+{
+  bool     is_active;
+  bool     is_failed;     // 스트림 중간에 실패, 끝날 때까지 같은 addr 의 패킷은 거부
+  uint8_t  err_code;
+  uint32_t addr_start;    // 압축 해제 데이터가 Write 되는 시작 주소
+  uint32_t stage_addr;    // boot_stage_buf[0] 의 주소
+  uint32_t stage_len;
+  lz_t     lz;
+} boot_decomp_t;
+
+typedef struct
+{
+  bool     is_active;
+  uint8_t  err_code;
+  uint32_t addr_start;    // 패치 영역의 시작 주소 (섹터 단위)
+  uint32_t old_length;
+  uint32_t new_length;
+  uint32_t stage_addr;    // boot_stage_buf[0] 의 주소
+  uint32_t stage_len;
+  bool     is_tag;        // 태그 섹터를 다시 썼으면 패치가 끝난 후 magic 을 Write
+  uint32_t tag_magic;
+  delta_t  delta;
+} boot_delta_t;
+
+
+enum
+{
+  BOOT_WINDOW_NEW,
+  BOOT_WINDOW_DUP,
+  BOOT_WINDOW_OUT,
+};
 
 
 
@@ -28,6 +131,14 @@ extern firm_version_t boot_ver;
 firm_version_t *p_boot_ver = &boot_ver;
 firm_version_t *p_firm_ver = (firm_version_t *)(FLASH_ADDR_FW_VER);
 firm_tag_t     *p_firm_tag = (firm_tag_t *)FLASH_ADDR_TAG;
+boot_verify_t  *p_boot_verify = (boot_verify_t *)FLASH_ADDR_BOOT_INFO;
+
+static boot_write_t  boot_write;
+static boot_window_t boot_window;
+static boot_decomp_t boot_decomp;
+static boot_delta_t  boot_delta;
+static boot_baud_t   boot_baud;
+static uint8_t       boot_stage_buf[BOOT_STAGE_LENGTH];   // 압축 해제와 패치에서 같이 사용
 
 
 static void bootCmdReadBootVersion(cmd_t *p_cmd);
@@ -36,18 +147,75 @@ static void bootCmdReadFirmVersion(cmd_t *p_cmd);
 static void bootCmdReadFirmName(cmd_t *p_cmd);
 static void bootCmdFlashErase(cmd_t *p_cmd);
 static void bootCmdFlashWrite(cmd_t *p_cmd);
+static void bootCmdFlashWriteCompressed(cmd_t *p_cmd);
+static void bootCmdDeltaBegin(cmd_t *p_cmd);
+static void bootCmdDeltaWrite(cmd_t *p_cmd);
+static void bootCmdDeltaEnd(cmd_t *p_cmd);
+static void bootCmdFlashReadCrc(cmd_t *p_cmd);
+static void bootCmdFlashRead(cmd_t *p_cmd);
+static void bootCmdSetBaud(cmd_t *p_cmd);
 static void bootCmdJumpToFw(cmd_t *p_cmd);
+static void bootCmdReadCaps(cmd_t *p_cmd);
+static void bootCmdReadUartStat(cmd_t *p_cmd);
 static void bootCmdLedControl(cmd_t *p_cmd);
 
 
 static bool bootIsFlashRange(uint32_t addr_begin, uint32_t length);
+static bool bootIsReadRange(uint32_t addr_begin, uint32_t length);
+static bool bootIsFlashErased(uint32_t addr, uint32_t length);
+static bool bootWriteStep(void);
+static void bootWriteFlush(void);
+static void bootWriteSendErr(cmd_t *p_cmd, uint8_t cmd);
+static uint8_t bootWindowCheck(uint8_t seq);
+static void bootWindowAdd(uint8_t seq);
+static void bootWindowSendResp(cmd_t *p_cmd, uint8_t cmd, uint8_t err_code);
+static uint8_t bootDecompRead(uint32_t index);
+static bool bootDecompWrite(uint8_t data);
+static void bootDecompStage(void);
+static void bootDecompEnd(void);
+static bool bootDeltaRead(uint32_t offset, uint8_t *p_data);
+static bool bootDeltaWrite(uint8_t data);
+static void bootDeltaStage(void);
 
 
 
 
 void bootInit(void)
 {
+  boot_write.is_busy  = false;
+  boot_write.err_code = CMD_OK;
+
+  boot_window.size = 0;
+  boot_window.base = 0;
+  boot_window.bits = 0;
+
+  boot_decomp.is_active = false;
+  boot_decomp.is_failed = false;
+  boot_decomp.err_code  = CMD_OK;
+
+  boot_delta.is_active = false;
+  boot_delta.err_code  = CMD_OK;
+
+  boot_baud.is_pending = false;
+}
+
+void bootUpdate(cmd_t *p_cmd)
+{
+  // 수신이 밀려 있으면 패킷 수신을 먼저 처리하고,
+  // 그렇지 않을 때 대기중인 데이터를 조금씩 Flash에 Write 한다.
+  //
+  if (boot_write.is_busy == true && uartAvailable(p_cmd->ch) < BOOT_WRITE_RX_THRESHOLD)
+  {
+    bootWriteStep();
+  }
 
+  // 정해진 시간안에 새 속도로 패킷을 받지 못하면 이전 속도로 복귀.
+  //
+  if (boot_baud.is_pending == true && millis()-boot_baud.pre_time >= BOOT_BAUD_CONFIRM_TIME)
+  {
+    boot_baud.is_pending = false;
+    cmdSetBaud(p_cmd, boot_baud.baud_old);
+  }
 }
 
 bool bootVerifyFw(void)
@@ -78,10 +246,7 @@ bool bootVerifyCrc(void)
   p_data = (uint8_t *)p_firm_tag->tag_flash_start;
   fw_crc = 0;
 
-  for (int i=0; i<p_firm_tag->tag_flash_length; i++)
-  {
-    utilUpdateCrc(&fw_crc, p_data[i]);
-  }
+  crcUpdate(&fw_crc, p_data, p_firm_tag->tag_flash_length);
 
   if (fw_crc == p_firm_tag->tag_flash_crc)
   {
@@ -93,16 +258,168 @@ bool bootVerifyCrc(void)
   }
 }
 
+bool bootVerifyCache(void)
+{
+  uint32_t data = 0;
+
+
+  if (p_firm_tag->magic_number != FLASH_MAGIC_NUMBER)
+  {
+    return false;
+  }
+
+  if (p_boot_verify->magic     != BOOT_VERIFY_MAGIC ||
+      p_boot_verify->fw_start  != p_firm_tag->tag_flash_start ||
+      p_boot_verify->fw_length != p_firm_tag->tag_flash_length ||
+      p_boot_verify->fw_crc    != p_firm_tag->tag_flash_crc)
+  {
+    return false;
+  }
+
+#if BOOT_VERIFY_PARANOID_CNT > 0
+  // 남은 횟수가 없으면 CRC 전체 확인.
+  //
+  for (int i=0; i<BOOT_VERIFY_PARANOID_CNT-1; i++)
+  {
+    if (p_boot_verify->boot_cnt[i] == 0xFFFFFFFF)
+    {
+      flashWrite((uint32_t)&p_boot_verify->boot_cnt[i], (uint8_t *)&data, 4);
+      return true;
+    }
+  }
+  return false;
+#else
+  (void)data;
+  return true;
+#endif
+}
+
+void bootVerifyCacheSave(void)
+{
+  boot_verify_t info;
+
+
+  info.magic     = BOOT_VERIFY_MAGIC;
+  info.fw_start  = p_firm_tag->tag_flash_start;
+  info.fw_length = p_firm_tag->tag_flash_length;
+  info.fw_crc    = p_firm_tag->tag_flash_crc;
+
+  // 같은 이미지의 기록이 있고 사용한 횟수가 없으면 다시 쓰지 않는다.
+  // (BOOT_VERIFY_PARANOID_CNT 1 은 횟수를 쓰지 않으므로 매번 CRC 확인만 하고 Erase 하지 않음)
+  //
+  if (p_boot_verify->magic       == info.magic &&
+      p_boot_verify->fw_start    == info.fw_start &&
+      p_boot_verify->fw_length   == info.fw_length &&
+      p_boot_verify->fw_crc      == info.fw_crc &&
+      p_boot_verify->boot_cnt[0] == 0xFFFFFFFF)
+  {
+    return;
+  }
+
+  if (flashErase(FLASH_ADDR_BOOT_INFO, sizeof(boot_verify_t)) != true)
+  {
+    return;
+  }
+
+  // magic 을 마지막에 Write 하여 중간에 전원이 꺼져도 무효가 되도록 한다.
+  //
+  flashWrite((uint32_t)&p_boot_verify->fw_start, (uint8_t *)&info.fw_start, 12);
+  flashWrite((uint32_t)&p_boot_verify->magic, (uint8_t *)&info.magic, 4);
+}
+
+void bootVerifyCacheClear(void)
+{
+  if (p_boot_verify->magic != 0xFFFFFFFF)
+  {
+    flashErase(FLASH_ADDR_BOOT_INFO, sizeof(boot_verify_t));
+  }
+}
+
+#ifdef _USE_CRC_BENCH
+void bootCrcBench(void)
+{
+  uint8_t slice_tbl[3] = {1, 4, 8};
+  uint32_t length;
+  uint32_t cycles;
+  uint16_t crc;
+
+
+  // DWT 의 cycle counter 로 Flash 전체 CRC 계산 시간을 측정
+  //
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+  length = FLASH_ADDR_END - FLASH_ADDR_START;
+
+  logPrintf("crc bench \t\t: %d bytes\r\n", length);
+  for (int i=0; i<3; i++)
+  {
+    crc = 0;
+    DWT->CYCCNT = 0;
+    crcUpdateSlice(slice_tbl[i], &crc, (uint8_t *)FLASH_ADDR_START, length);
+    cycles = DWT->CYCCNT;
+
+    logPrintf("crc by%d \t\t: %d cycles, %d ms, 0x%04X\r\n",
+              slice_tbl[i],
+              cycles,
+              cycles / (SystemCoreClock / 1000),
+              crc);
+  }
+}
+#endif
+
 void bootJumpToFw(void)
 {
   void (**jump_func)(void) = (void (**)(void))(FLASH_ADDR_FW + 4);
 
+  // 인터럽트를 끄기 전에 송신 버퍼에 남은 데이터를 모두 보낸다.
+  //
+  uartFlushTx(_DEF_UART1);
+
   bspDeInit();
   (*jump_func)();
 }
 
 void bootProcessCmd(cmd_t *p_cmd)
 {
+  // 새 속도로 패킷을 받았으므로 속도 변경 완료.
+  //
+  boot_baud.is_pending = false;
+
+  // 압축 데이터가 아니면 압축 해제 중인 데이터를 마무리.
+  //
+  if (p_cmd->rx_packet.cmd != BOOT_CMD_FLASH_WRITE_COMPRESSED)
+  {
+    bootDecompEnd();
+  }
+
+  // 패치 중에 다른 명령이 오면 패치를 중단. (태그의 magic 을 쓰지 않으므로 이미지는 무효)
+  //
+  if (p_cmd->rx_packet.cmd != BOOT_CMD_DELTA_WRITE &&
+      p_cmd->rx_packet.cmd != BOOT_CMD_DELTA_END)
+  {
+    boot_delta.is_active = false;
+  }
+
+  // Flash 를 변경하는 명령이면 펌웨어 확인 기록을 지움.
+  //
+  if (p_cmd->rx_packet.cmd == BOOT_CMD_FLASH_ERASE ||
+      p_cmd->rx_packet.cmd == BOOT_CMD_FLASH_WRITE ||
+      p_cmd->rx_packet.cmd == BOOT_CMD_FLASH_WRITE_COMPRESSED ||
+      p_cmd->rx_packet.cmd == BOOT_CMD_DELTA_BEGIN)
+  {
+    bootVerifyCacheClear();
+  }
+
+  // Write 명령이 아니면 이전에 받은 데이터를 모두 Write 한 후 처리.
+  //
+  if (p_cmd->rx_packet.cmd != BOOT_CMD_FLASH_WRITE &&
+      p_cmd->rx_packet.cmd != BOOT_CMD_FLASH_WRITE_COMPRESSED &&
+      p_cmd->rx_packet.cmd != BOOT_CMD_DELTA_WRITE)
+  {
+    bootWriteFlush();
+  }
+
   switch(p_cmd->rx_packet.cmd)
   {
     case BOOT_CMD_LED_CONTROL:
@@ -133,10 +450,46 @@ void bootProcessCmd(cmd_t *p_cmd)
       bootCmdFlashWrite(p_cmd);
       break;
 
+    case BOOT_CMD_FLASH_WRITE_COMPRESSED:
+      bootCmdFlashWriteCompressed(p_cmd);
+      break;
+
+    case BOOT_CMD_DELTA_BEGIN:
+      bootCmdDeltaBegin(p_cmd);
+      break;
+
+    case BOOT_CMD_DELTA_WRITE:
+      bootCmdDeltaWrite(p_cmd);
+      break;
+
+    case BOOT_CMD_DELTA_END:
+      bootCmdDeltaEnd(p_cmd);
+      break;
+
+    case BOOT_CMD_FLASH_READ_CRC:
+      bootCmdFlashReadCrc(p_cmd);
+      break;
+
+    case BOOT_CMD_FLASH_READ:
+      bootCmdFlashRead(p_cmd);
+      break;
+
+    case BOOT_CMD_SET_BAUD:
+      bootCmdSetBaud(p_cmd);
+      break;
+
     case BOOT_CMD_JUMP_TO_FW:
       bootCmdJumpToFw(p_cmd);
       break;
 
+    case BOOT_CMD_READ_CAPS:
+      bootCmdReadCaps(p_cmd);
+      break;
+
+    case BOOT_CMD_READ_UART_STAT:
+      bootCmdReadUartStat(p_cmd);
+      break;
+
     default:
       cmdSendResp(p_cmd, p_cmd->rx_packet.cmd, BOOT_ERR_WRONG_CMD, NULL, 0);
       break;
@@ -187,10 +540,21 @@ void bootCmdFlashErase(cmd_t *p_cmd)
   // 유효한 메모리 영역인지 확인.
   if (bootIsFlashRange(addr, length) == true)
   {
-    // 메모리를 지움.
-    if (flashErase(addr, length) != true)
+    uint32_t sector_addr;
+
+    // 메모리를 섹터 단위로 지움. (이미 지워진 섹터는 생략)
+    sector_addr = addr - (addr%BOOT_SECTOR_LENGTH);
+    while(sector_addr < addr + length)
     {
-      err_code = BOOT_ERR_FLASH_ERASE;
+      if (bootIsFlashErased(sector_addr, BOOT_SECTOR_LENGTH) != true)
+      {
+        if (flashErase(sector_addr, BOOT_SECTOR_LENGTH) != true)
+        {
+          err_code = BOOT_ERR_FLASH_ERASE;
+          break;
+        }
+      }
+      sector_addr += BOOT_SECTOR_LENGTH;
     }
   }
   else
@@ -206,6 +570,8 @@ void bootCmdFlashWrite(cmd_t *p_cmd)
   uint8_t err_code = CMD_OK;
   uint32_t addr;
   uint32_t length;
+  bool is_window;
+  uint8_t window_state;
   cmd_packet_t *p_packet;
 
   p_packet = &p_cmd->rx_packet;
@@ -222,91 +588,973 @@ void bootCmdFlashWrite(cmd_t *p_cmd)
   length |= (uint32_t)(p_packet->data[7] << 24);
 
 
-  // 유효한 메모리 영역인지 확인.
-  if (bootIsFlashRange(addr, length) == true)
+  // 길이 0 은 Write 종료. 앞의 패킷들에서 생긴 Write 에러를 실패한 주소와 같이 전달.
+  //
+  if (p_packet->length == 8 && length == 0)
   {
-    // 데이터를 Write.
-    if (flashWrite(addr, &p_packet->data[8], length) != true)
+    bootWriteSendErr(p_cmd, BOOT_CMD_FLASH_WRITE);
+    return;
+  }
+
+
+  // Window 모드에서 이미 받은 SEQ 는 다시 Write 하지 않고 상태만 응답.
+  //
+  is_window = (p_packet->is_seq == true && boot_window.size > 0);
+  if (is_window == true)
+  {
+    window_state = bootWindowCheck(p_packet->seq);
+
+    if (window_state == BOOT_WINDOW_DUP)
     {
-      err_code = BOOT_ERR_FLASH_WRITE;
+      bootWindowSendResp(p_cmd, BOOT_CMD_FLASH_WRITE, CMD_OK);
+      return;
+    }
+    if (window_state == BOOT_WINDOW_OUT)
+    {
+      bootWindowSendResp(p_cmd, BOOT_CMD_FLASH_WRITE, BOOT_ERR_WRONG_SEQ);
+      return;
     }
   }
-  else
+
+
+  // 이전 패킷을 아직 Write 중이면 마저 Write.
+  // 이전 패킷의 Write 에러는 이 패킷과 상관이 없으므로 응답하지 않고 Write 종료 때 전달.
+  //
+  bootWriteFlush();
+
+
+  if (p_packet->length < 8 || length > (uint32_t)(p_packet->length - 8))
+  {
+    err_code = BOOT_ERR_BUF_OVF;
+  }
+  // 유효한 메모리 영역인지 확인.
+  else if (bootIsFlashRange(addr, length) != true)
   {
     err_code = BOOT_ERR_WRONG_RANGE;
   }
+  else if (addr%4 != 0)
+  {
+    err_code = BOOT_ERR_FLASH_WRITE;
+  }
+  else
+  {
+    // 데이터를 복사해 두고 응답을 먼저 보낸 후, 다음 패킷을 받는 동안 Write.
+    memcpy(boot_write.buf, &p_packet->data[8], length);
 
-  cmdSendResp(p_cmd, BOOT_CMD_FLASH_WRITE, err_code, NULL, 0);
+    boot_write.addr    = addr;
+    boot_write.length  = length;
+    boot_write.index   = 0;
+    boot_write.is_busy = true;
+  }
+
+  if (is_window == true)
+  {
+    if (err_code == CMD_OK)
+    {
+      bootWindowAdd(p_packet->seq);
+    }
+    bootWindowSendResp(p_cmd, BOOT_CMD_FLASH_WRITE, err_code);
+  }
+  else
+  {
+    cmdSendResp(p_cmd, BOOT_CMD_FLASH_WRITE, err_code, NULL, 0);
+  }
 }
 
-void bootCmdJumpToFw(cmd_t *p_cmd)
+void bootCmdFlashWriteCompressed(cmd_t *p_cmd)
 {
-  if (bootVerifyFw() == true)
+  uint8_t err_code = CMD_OK;
+  uint32_t addr;
+  uint32_t length;
+  cmd_packet_t *p_packet;
+
+  p_packet = &p_cmd->rx_packet;
+
+
+  if (p_packet->length < 8)
   {
-    if (bootVerifyCrc() == true)
+    cmdSendResp(p_cmd, BOOT_CMD_FLASH_WRITE_COMPRESSED, BOOT_ERR_BUF_OVF, NULL, 0);
+    return;
+  }
+
+  addr  = (uint32_t)(p_packet->data[0] <<  0);
+  addr |= (uint32_t)(p_packet->data[1] <<  8);
+  addr |= (uint32_t)(p_packet->data[2] << 16);
+  addr |= (uint32_t)(p_packet->data[3] << 24);
+
+  length  = (uint32_t)(p_packet->data[4] <<  0);
+  length |= (uint32_t)(p_packet->data[5] <<  8);
+  length |= (uint32_t)(p_packet->data[6] << 16);
+  length |= (uint32_t)(p_packet->data[7] << 24);
+
+
+  // addr 은 압축 해제 데이터의 시작 주소로, 하나의 스트림 동안 같은 값을 보낸다.
+  // 시작 주소가 바뀌면 새로운 스트림을 시작하고, length 가 0 이면 스트림을 끝낸다.
+  //
+  if ((boot_decomp.is_active == true || boot_decomp.is_failed == true) && boot_decomp.addr_start != addr)
+  {
+    bootDecompEnd();
+  }
+
+  // 실패한 스트림의 나머지 데이터를 새 스트림으로 풀지 않도록 끝 패킷까지 모두 에러로 응답.
+  //
+  if (boot_decomp.is_failed == true)
+  {
+    if (length == 0)
     {
-      cmdSendResp(p_cmd, BOOT_CMD_JUMP_TO_FW, CMD_OK, NULL, 0);
-      delay(100);
-      bootJumpToFw();
+      boot_decomp.is_failed = false;
+      bootWriteFlush();
     }
-    else
+    cmdSendResp(p_cmd, BOOT_CMD_FLASH_WRITE_COMPRESSED, BOOT_ERR_DECOMPRESS, NULL, 0);
+    return;
+  }
+
+  if (length > (uint32_t)(p_packet->length - 8))
+  {
+    err_code = BOOT_ERR_BUF_OVF;
+  }
+  else if (length == 0)
+  {
+    bootDecompEnd();
+    bootWriteFlush();
+  }
+  else
+  {
+    if (boot_decomp.is_active != true)
     {
-      cmdSendResp(p_cmd, BOOT_CMD_JUMP_TO_FW, BOOT_ERR_FW_CRC, NULL, 0);
+      if (bootIsFlashRange(addr, 4) == true && addr%4 == 0)
+      {
+        boot_decomp.is_active  = true;
+        boot_decomp.addr_start = addr;
+        boot_decomp.stage_addr = addr;
+        boot_decomp.stage_len  = 0;
+        lzCreate(&boot_decomp.lz, bootDecompRead, bootDecompWrite);
+      }
+      else
+      {
+        err_code = BOOT_ERR_WRONG_RANGE;
+      }
+    }
+
+    if (boot_decomp.is_active == true)
+    {
+      if (lzDecode(&boot_decomp.lz, &p_packet->data[8], length) != true)
+      {
+        boot_decomp.is_active = false;
+        boot_decomp.is_failed = true;
+        boot_decomp.err_code  = BOOT_ERR_DECOMPRESS;
+      }
     }
   }
-  else
+
+  // 이전 에러를 포함하여 스트림에서 발생한 에러를 전달.
+  //
+  if (err_code == CMD_OK)
   {
-    cmdSendResp(p_cmd, BOOT_CMD_JUMP_TO_FW, BOOT_ERR_INVALID_FW, NULL, 0);
+    if (boot_decomp.err_code != CMD_OK)
+    {
+      err_code = boot_decomp.err_code;
+      boot_decomp.err_code = CMD_OK;
+    }
+    else if (boot_write.err_code != CMD_OK)
+    {
+      err_code = boot_write.err_code;
+      boot_write.err_code = CMD_OK;
+    }
   }
+
+  cmdSendResp(p_cmd, BOOT_CMD_FLASH_WRITE_COMPRESSED, err_code, NULL, 0);
 }
 
-void bootCmdLedControl(cmd_t *p_cmd)
+void bootCmdDeltaBegin(cmd_t *p_cmd)
 {
   uint8_t err_code = CMD_OK;
+  uint32_t addr;
+  uint32_t new_length;
+  uint32_t old_length;
+  uint16_t old_crc;
+  uint16_t crc;
+  uint8_t *p_data;
   cmd_packet_t *p_packet;
 
-
   p_packet = &p_cmd->rx_packet;
 
-  if (p_packet->data[0] == 0)
+
+  if (p_packet->length < 14)
   {
-    ledOff(_DEF_LED1);
+    cmdSendResp(p_cmd, BOOT_CMD_DELTA_BEGIN, BOOT_ERR_BUF_OVF, NULL, 0);
+    return;
   }
-  else if (p_packet->data[0] == 1)
+
+  addr  = (uint32_t)(p_packet->data[0] <<  0);
+  addr |= (uint32_t)(p_packet->data[1] <<  8);
+  addr |= (uint32_t)(p_packet->data[2] << 16);
+  addr |= (uint32_t)(p_packet->data[3] << 24);
+
+  new_length  = (uint32_t)(p_packet->data[4] <<  0);
+  new_length |= (uint32_t)(p_packet->data[5] <<  8);
+  new_length |= (uint32_t)(p_packet->data[6] << 16);
+  new_length |= (uint32_t)(p_packet->data[7] << 24);
+
+  old_length  = (uint32_t)(p_packet->data[8]  <<  0);
+  old_length |= (uint32_t)(p_packet->data[9]  <<  8);
+  old_length |= (uint32_t)(p_packet->data[10] << 16);
+  old_length |= (uint32_t)(p_packet->data[11] << 24);
+
+  old_crc  = (uint16_t)(p_packet->data[12] << 0);
+  old_crc |= (uint16_t)(p_packet->data[13] << 8);
+
+
+  if (addr%BOOT_STAGE_LENGTH != 0 ||
+      new_length == 0 ||
+      old_length == 0 ||
+      bootIsFlashRange(addr, max(new_length, old_length)) != true)
   {
-    ledOn(_DEF_LED1);
+    err_code = BOOT_ERR_WRONG_RANGE;
   }
-  else if (p_packet->data[0] == 2)
+  else
   {
-    ledToggle(_DEF_LED1);
+    // 패치를 만든 이미지와 현재 이미지가 같은지 확인.
+    //
+    p_data = (uint8_t *)addr;
+    crc = 0;
+    crcUpdate(&crc, p_data, old_length);
+
+    if (crc != old_crc)
+    {
+      err_code = BOOT_ERR_DELTA_BASE;
+    }
   }
-  else
+
+  if (err_code == CMD_OK)
   {
-    err_code = BOOT_ERR_LED;
+    boot_delta.is_active  = true;
+    boot_delta.err_code   = CMD_OK;
+    boot_delta.addr_start = addr;
+    boot_delta.old_length = old_length;
+    boot_delta.new_length = new_length;
+    boot_delta.stage_addr = addr;
+    boot_delta.stage_len  = 0;
+    boot_delta.is_tag     = false;
+    deltaCreate(&boot_delta.delta, bootDeltaRead, bootDeltaWrite);
   }
 
-  cmdSendResp(p_cmd, BOOT_CMD_LED_CONTROL, err_code, NULL, 0);
+  cmdSendResp(p_cmd, BOOT_CMD_DELTA_BEGIN, err_code, NULL, 0);
 }
 
-bool bootIsFlashRange(uint32_t addr_begin, uint32_t length)
+void bootCmdDeltaWrite(cmd_t *p_cmd)
 {
-  bool ret = false;
-  uint32_t addr_end;
-  uint32_t flash_start;
-  uint32_t flash_end;
+  uint8_t err_code = CMD_OK;
+  uint32_t addr;
+  uint32_t length;
+  cmd_packet_t *p_packet;
 
+  p_packet = &p_cmd->rx_packet;
 
-  addr_end = addr_begin + length - 1;
 
-  flash_start = FLASH_ADDR_START;
-  flash_end   = FLASH_ADDR_END;
+  addr  = (uint32_t)(p_packet->data[0] <<  0);
+  addr |= (uint32_t)(p_packet->data[1] <<  8);
+  addr |= (uint32_t)(p_packet->data[2] << 16);
+  addr |= (uint32_t)(p_packet->data[3] << 24);
 
-  if ((addr_begin >= flash_start) && (addr_begin < flash_end) &&
-      (addr_end   >= flash_start) && (addr_end   < flash_end))
+  length  = (uint32_t)(p_packet->data[4] <<  0);
+  length |= (uint32_t)(p_packet->data[5] <<  8);
+  length |= (uint32_t)(p_packet->data[6] << 16);
+  length |= (uint32_t)(p_packet->data[7] << 24);
+
+
+  if (p_packet->length < 8 || length > (uint32_t)(p_packet->length - 8))
   {
-    ret = true;
+    err_code = BOOT_ERR_BUF_OVF;
+  }
+  else if (boot_delta.is_active != true || boot_delta.addr_start != addr)
+  {
+    err_code = BOOT_ERR_DELTA;
+  }
+  else if (deltaDecode(&boot_delta.delta, &p_packet->data[8], length) != true)
+  {
+    boot_delta.is_active = false;
+    err_code = BOOT_ERR_DELTA;
   }
 
-
-  return ret;
+  if (err_code == CMD_OK)
+  {
+    if (boot_delta.err_code != CMD_OK)
+    {
+      err_code = boot_delta.err_code;
+      boot_delta.is_active = false;
+    }
+    else if (boot_write.err_code != CMD_OK)
+    {
+      err_code = boot_write.err_code;
+      boot_write.err_code = CMD_OK;
+      boot_delta.is_active = false;
+    }
+  }
+
+  cmdSendResp(p_cmd, BOOT_CMD_DELTA_WRITE, err_code, NULL, 0);
+}
+
+void bootCmdDeltaEnd(cmd_t *p_cmd)
+{
+  uint8_t err_code = CMD_OK;
+
+
+  if (boot_delta.is_active != true)
+  {
+    cmdSendResp(p_cmd, BOOT_CMD_DELTA_END, BOOT_ERR_DELTA, NULL, 0);
+    return;
+  }
+  boot_delta.is_active = false;
+
+  if (deltaIsDone(&boot_delta.delta) != true ||
+      boot_delta.delta.out_len != boot_delta.new_length)
+  {
+    err_code = BOOT_ERR_DELTA;
+  }
+  else
+  {
+    bootDeltaStage();
+    bootWriteFlush();
+
+    if (boot_delta.err_code != CMD_OK)
+    {
+      err_code = boot_delta.err_code;
+    }
+    else if (boot_write.err_code != CMD_OK)
+    {
+      err_code = boot_write.err_code;
+      boot_write.err_code = CMD_OK;
+    }
+  }
+
+  // 모든 섹터를 문제없이 썼을 때만 태그의 magic 을 Write 하여 이미지를 유효하게 한다.
+  //
+  if (err_code == CMD_OK && boot_delta.is_tag == true)
+  {
+    if (flashWrite(FLASH_ADDR_TAG, (uint8_t *)&boot_delta.tag_magic, 4) != true ||
+        memcmp((void *)FLASH_ADDR_TAG, &boot_delta.tag_magic, 4) != 0)
+    {
+      err_code = BOOT_ERR_FLASH_WRITE;
+    }
+  }
+
+  cmdSendResp(p_cmd, BOOT_CMD_DELTA_END, err_code, NULL, 0);
+}
+
+void bootCmdFlashReadCrc(cmd_t *p_cmd)
+{
+  uint8_t err_code = CMD_OK;
+  uint32_t addr;
+  uint32_t length;
+  uint32_t sector_cnt;
+  uint16_t crc;
+  cmd_packet_t *p_packet;
+
+  p_packet = &p_cmd->rx_packet;
+
+
+  addr  = (uint32_t)(p_packet->data[0] <<  0);
+  addr |= (uint32_t)(p_packet->data[1] <<  8);
+  addr |= (uint32_t)(p_packet->data[2] << 16);
+  addr |= (uint32_t)(p_packet->data[3] << 24);
+
+  length  = (uint32_t)(p_packet->data[4] <<  0);
+  length |= (uint32_t)(p_packet->data[5] <<  8);
+  length |= (uint32_t)(p_packet->data[6] << 16);
+  length |= (uint32_t)(p_packet->data[7] << 24);
+
+  sector_cnt = (length + BOOT_SECTOR_LENGTH - 1) / BOOT_SECTOR_LENGTH;
+
+
+  if (p_packet->length < 8)
+  {
+    err_code = BOOT_ERR_BUF_OVF;
+  }
+  else if (addr%BOOT_SECTOR_LENGTH != 0 || bootIsFlashRange(addr, sector_cnt * BOOT_SECTOR_LENGTH) != true)
+  {
+    err_code = BOOT_ERR_WRONG_RANGE;
+  }
+  else if (sector_cnt * 2 > CMD_MAX_DATA_LENGTH)
+  {
+    err_code = BOOT_ERR_BUF_OVF;
+  }
+
+  if (err_code != CMD_OK)
+  {
+    cmdSendResp(p_cmd, BOOT_CMD_FLASH_READ_CRC, err_code, NULL, 0);
+    return;
+  }
+
+  // 섹터마다 CRC16 을 보내면 호스트는 내용이 같은 섹터를 보내지 않는다.
+  // (Write 대기 데이터는 모두 Write 한 후이므로 boot_write.buf 를 응답 버퍼로 사용)
+  //
+  for (int i=0; i<sector_cnt; i++)
+  {
+    crc = 0;
+    crcUpdate(&crc, (uint8_t *)(addr + i*BOOT_SECTOR_LENGTH), BOOT_SECTOR_LENGTH);
+
+    boot_write.buf[i*2 + 0] = (uint8_t)(crc >> 0);
+    boot_write.buf[i*2 + 1] = (uint8_t)(crc >> 8);
+  }
+
+  cmdSendResp(p_cmd, BOOT_CMD_FLASH_READ_CRC, CMD_OK, boot_write.buf, sector_cnt * 2);
+}
+
+void bootCmdFlashRead(cmd_t *p_cmd)
+{
+  uint8_t err_code = CMD_OK;
+  uint32_t addr;
+  uint32_t length;
+  uint16_t crc;
+  cmd_packet_t *p_packet;
+
+  p_packet = &p_cmd->rx_packet;
+
+
+  addr  = (uint32_t)(p_packet->data[0] <<  0);
+  addr |= (uint32_t)(p_packet->data[1] <<  8);
+  addr |= (uint32_t)(p_packet->data[2] << 16);
+  addr |= (uint32_t)(p_packet->data[3] << 24);
+
+  length  = (uint32_t)(p_packet->data[4] <<  0);
+  length |= (uint32_t)(p_packet->data[5] <<  8);
+  length |= (uint32_t)(p_packet->data[6] << 16);
+  length |= (uint32_t)(p_packet->data[7] << 24);
+
+
+  if (p_packet->length < 8 || length == 0 || bootIsReadRange(addr, length) != true)
+  {
+    err_code = BOOT_ERR_WRONG_RANGE;
+  }
+  else if (length + 2 > CMD_MAX_DATA_LENGTH)
+  {
+    err_code = BOOT_ERR_BUF_OVF;
+  }
+
+  if (err_code != CMD_OK)
+  {
+    cmdSendResp(p_cmd, BOOT_CMD_FLASH_READ, err_code, NULL, 0);
+    return;
+  }
+
+  // 패킷 체크섬은 XOR 이라 같은 위치 2비트 오류를 못 찾으므로 데이터 뒤에 CRC16 을 붙인다.
+  // (Write 대기 데이터는 모두 Write 한 후이므로 boot_write.buf 를 응답 버퍼로 사용)
+  //
+  crc = 0;
+  crcUpdate(&crc, (uint8_t *)addr, length);
+
+  memcpy(boot_write.buf, (uint8_t *)addr, length);
+  boot_write.buf[length + 0] = (uint8_t)(crc >> 0);
+  boot_write.buf[length + 1] = (uint8_t)(crc >> 8);
+
+  cmdSendResp(p_cmd, BOOT_CMD_FLASH_READ, CMD_OK, boot_write.buf, length + 2);
+}
+
+void bootCmdSetBaud(cmd_t *p_cmd)
+{
+  uint32_t baud;
+  uint32_t baud_old;
+  cmd_packet_t *p_packet;
+
+  p_packet = &p_cmd->rx_packet;
+
+
+  baud  = (uint32_t)(p_packet->data[0] <<  0);
+  baud |= (uint32_t)(p_packet->data[1] <<  8);
+  baud |= (uint32_t)(p_packet->data[2] << 16);
+  baud |= (uint32_t)(p_packet->data[3] << 24);
+
+  if (p_packet->length < 4 || uartGetBaudError(p_cmd->ch, baud) > UART_BAUD_ERR_MAX)
+  {
+    cmdSendResp(p_cmd, BOOT_CMD_SET_BAUD, BOOT_ERR_BAUD, NULL, 0);
+    return;
+  }
+
+  // 이전 속도로 응답을 보낸 후 변경하고,
+  // 호스트가 새 속도로 보내는 패킷을 기다린다.
+  //
+  baud_old = p_cmd->baud;
+  cmdSendResp(p_cmd, BOOT_CMD_SET_BAUD, CMD_OK, NULL, 0);
+
+  if (cmdSetBaud(p_cmd, baud) == true)
+  {
+    boot_baud.is_pending = true;
+    boot_baud.baud_old   = baud_old;
+    boot_baud.pre_time   = millis();
+  }
+}
+
+void bootCmdJumpToFw(cmd_t *p_cmd)
+{
+  if (boot_decomp.err_code != CMD_OK)
+  {
+    boot_decomp.err_code = CMD_OK;
+    cmdSendResp(p_cmd, BOOT_CMD_JUMP_TO_FW, BOOT_ERR_DECOMPRESS, NULL, 0);
+  }
+  else if (boot_write.err_code != CMD_OK)
+  {
+    bootWriteSendErr(p_cmd, BOOT_CMD_JUMP_TO_FW);
+  }
+  else if (bootVerifyFw() == true)
+  {
+    if (bootVerifyCrc() == true)
+    {
+      bootVerifyCacheSave();
+      cmdSendResp(p_cmd, BOOT_CMD_JUMP_TO_FW, CMD_OK, NULL, 0);
+      delay(100);
+      bootJumpToFw();
+    }
+    else
+    {
+      cmdSendResp(p_cmd, BOOT_CMD_JUMP_TO_FW, BOOT_ERR_FW_CRC, NULL, 0);
+    }
+  }
+  else
+  {
+    cmdSendResp(p_cmd, BOOT_CMD_JUMP_TO_FW, BOOT_ERR_INVALID_FW, NULL, 0);
+  }
+}
+
+void bootCmdReadCaps(cmd_t *p_cmd)
+{
+  uint32_t caps;
+  uint8_t  resp[7];
+  cmd_packet_t *p_packet;
+
+
+  p_packet = &p_cmd->rx_packet;
+
+  // 요청한 Window 크기로 Window 모드를 시작. (0 이면 사용 안함)
+  //
+  if (p_packet->length >= 1)
+  {
+    boot_window.size = min(p_packet->data[0], BOOT_WINDOW_MAX);
+    boot_window.base = 0;
+    boot_window.bits = 0;
+  }
+
+  caps  = BOOT_CAPS_WRITE_PIPE | BOOT_CAPS_WINDOW | BOOT_CAPS_COMPRESS | BOOT_CAPS_DELTA;
+  caps |= BOOT_CAPS_SECTOR_CRC | BOOT_CAPS_SET_BAUD | BOOT_CAPS_FLASH_READ | BOOT_CAPS_UART_STAT;
+  caps |= BOOT_CAPS_WRITE_END;
+
+  resp[0] = (caps >>  0) & 0xFF;
+  resp[1] = (caps >>  8) & 0xFF;
+  resp[2] = (caps >> 16) & 0xFF;
+  resp[3] = (caps >> 24) & 0xFF;
+  resp[4] = boot_window.size;
+  resp[5] = (CMD_MAX_DATA_LENGTH >> 0) & 0xFF;
+  resp[6] = (CMD_MAX_DATA_LENGTH >> 8) & 0xFF;
+
+  cmdSendResp(p_cmd, BOOT_CMD_READ_CAPS, CMD_OK, resp, 7);
+}
+
+void bootCmdReadUartStat(cmd_t *p_cmd)
+{
+  uart_stat_t stat;
+  uint32_t value[5];
+  uint8_t  resp[20];
+  cmd_packet_t *p_packet;
+
+
+  p_packet = &p_cmd->rx_packet;
+
+  uartGetStat(p_cmd->ch, &stat);
+
+  value[0] = stat.rx_drop_cnt;
+  value[1] = stat.overrun_cnt;
+  value[2] = stat.parity_err_cnt;
+  value[3] = stat.frame_err_cnt;
+  value[4] = stat.rx_peak;
+
+  for (int i=0; i<5; i++)
+  {
+    resp[i*4 + 0] = (value[i] >>  0) & 0xFF;
+    resp[i*4 + 1] = (value[i] >>  8) & 0xFF;
+    resp[i*4 + 2] = (value[i] >> 16) & 0xFF;
+    resp[i*4 + 3] = (value[i] >> 24) & 0xFF;
+  }
+
+  // data[0] 이 1 이면 읽은 후 초기화. (속도 변경 중 생긴 오류를 빼고 보기 위함)
+  //
+  if (p_packet->length >= 1 && p_packet->data[0] == 1)
+  {
+    uartClearStat(p_cmd->ch);
+  }
+
+  cmdSendResp(p_cmd, BOOT_CMD_READ_UART_STAT, CMD_OK, resp, 20);
+}
+
+void bootCmdLedControl(cmd_t *p_cmd)
+{
+  uint8_t err_code = CMD_OK;
+  cmd_packet_t *p_packet;
+
+
+  p_packet = &p_cmd->rx_packet;
+
+  if (p_packet->data[0] == 0)
+  {
+    ledOff(_DEF_LED1);
+  }
+  else if (p_packet->data[0] == 1)
+  {
+    ledOn(_DEF_LED1);
+  }
+  else if (p_packet->data[0] == 2)
+  {
+    ledToggle(_DEF_LED1);
+  }
+  else
+  {
+    err_code = BOOT_ERR_LED;
+  }
+
+  cmdSendResp(p_cmd, BOOT_CMD_LED_CONTROL, err_code, NULL, 0);
+}
+
+bool bootIsFlashRange(uint32_t addr_begin, uint32_t length)
+{
+  bool ret = false;
+  uint32_t addr_end;
+  uint32_t flash_start;
+  uint32_t flash_end;
+
+
+  addr_end = addr_begin + length - 1;
+
+  flash_start = FLASH_ADDR_START;
+  flash_end   = FLASH_ADDR_END;
+
+  if ((addr_begin >= flash_start) && (addr_begin < flash_end) &&
+      (addr_end   >= flash_start) && (addr_end   < flash_end))
+  {
+    ret = true;
+  }
+
+
+  return ret;
+}
+
+// 읽기만 하는 주소 범위, 부트로더 영역(FLASH_ADDR_BOOT_INFO 포함)부터 펌웨어 영역까지의 Flash 와 RAM
+//
+bool bootIsReadRange(uint32_t addr_begin, uint32_t length)
+{
+  bool ret = false;
+  uint32_t addr_end;
+
+
+  addr_end = addr_begin + length - 1;
+
+  if (length == 0 || addr_end < addr_begin)
+  {
+    return false;
+  }
+
+  if (addr_end < FLASH_ADDR_END)
+  {
+    ret = true;
+  }
+  if ((addr_begin >= RAM_ADDR_START) && (addr_end < RAM_ADDR_END))
+  {
+    ret = true;
+  }
+
+
+  return ret;
+}
+
+bool bootIsFlashErased(uint32_t addr, uint32_t length)
+{
+  uint32_t *p_data = (uint32_t *)addr;
+
+
+  for (int i=0; i<length/4; i++)
+  {
+    if (p_data[i] != 0xFFFFFFFF)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool bootWriteStep(void)
+{
+  uint32_t addr;
+  uint32_t length;
+  uint8_t *p_data;
+
+
+  addr   = boot_write.addr + boot_write.index;
+  p_data = &boot_write.buf[boot_write.index];
+  length = min(boot_write.length - boot_write.index, BOOT_WRITE_STEP_LENGTH);
+
+  // 이미 같은 내용이면 Write 생략, 아니면 Write 후 다시 읽어서 확인.
+  if (memcmp((void *)addr, p_data, length) != 0)
+  {
+    if (flashWrite(addr, p_data, length) != true || memcmp((void *)addr, p_data, length) != 0)
+    {
+      if (boot_write.err_code == CMD_OK)
+      {
+        boot_write.err_addr = addr;
+      }
+      boot_write.err_code = BOOT_ERR_FLASH_WRITE;
+    }
+  }
+
+  boot_write.index += length;
+  if (boot_write.index >= boot_write.length)
+  {
+    boot_write.is_busy = false;
+  }
+
+  return boot_write.is_busy;
+}
+
+void bootWriteFlush(void)
+{
+  while(boot_write.is_busy == true)
+  {
+    bootWriteStep();
+  }
+}
+
+void bootWriteSendErr(cmd_t *p_cmd, uint8_t cmd)
+{
+  uint8_t err_code;
+  uint8_t resp[4];
+
+
+  bootWriteFlush();
+
+  err_code = boot_write.err_code;
+  boot_write.err_code = CMD_OK;
+
+  if (err_code != CMD_OK)
+  {
+    resp[0] = (boot_write.err_addr >>  0) & 0xFF;
+    resp[1] = (boot_write.err_addr >>  8) & 0xFF;
+    resp[2] = (boot_write.err_addr >> 16) & 0xFF;
+    resp[3] = (boot_write.err_addr >> 24) & 0xFF;
+    cmdSendResp(p_cmd, cmd, err_code, resp, 4);
+  }
+  else
+  {
+    cmdSendResp(p_cmd, cmd, CMD_OK, NULL, 0);
+  }
+}
+
+uint8_t bootWindowCheck(uint8_t seq)
+{
+  uint8_t offset;
+
+
+  offset = (uint8_t)(seq - boot_window.base);
+
+  // base 보다 이전 SEQ 는 이미 받은 패킷.
+  if (offset >= 0x80)
+  {
+    return BOOT_WINDOW_DUP;
+  }
+  if (offset >= boot_window.size)
+  {
+    return BOOT_WINDOW_OUT;
+  }
+  if (boot_window.bits & (1U<<offset))
+  {
+    return BOOT_WINDOW_DUP;
+  }
+
+  return BOOT_WINDOW_NEW;
+}
+
+void bootWindowAdd(uint8_t seq)
+{
+  uint8_t offset;
+
+
+  offset = (uint8_t)(seq - boot_window.base);
+
+  boot_window.bits |= (1U<<offset);
+
+  // 앞에서부터 연속으로 받은 만큼 Window 를 이동.
+  while(boot_window.bits & (1U<<0))
+  {
+    boot_window.bits >>= 1;
+    boot_window.base++;
+  }
+}
+
+void bootWindowSendResp(cmd_t *p_cmd, uint8_t cmd, uint8_t err_code)
+{
+  uint8_t resp[5];
+
+
+  // 누적 ACK(다음에 받아야 할 SEQ) 와 그 이후에 받은 SEQ 표시.
+  //
+  resp[0] = boot_window.base;
+  resp[1] = (boot_window.bits >>  0) & 0xFF;
+  resp[2] = (boot_window.bits >>  8) & 0xFF;
+  resp[3] = (boot_window.bits >> 16) & 0xFF;
+  resp[4] = (boot_window.bits >> 24) & 0xFF;
+
+  cmdSendResp(p_cmd, cmd, err_code, resp, 5);
+}
+
+uint8_t bootDecompRead(uint32_t index)
+{
+  uint32_t addr;
+
+
+  addr = boot_decomp.addr_start + index;
+
+  // 아직 Write 하지 않은 데이터는 버퍼에서 읽는다.
+  //
+  if (addr >= boot_decomp.stage_addr)
+  {
+    return boot_stage_buf[addr - boot_decomp.stage_addr];
+  }
+  if (boot_write.is_busy == true && addr >= boot_write.addr)
+  {
+    return boot_write.buf[addr - boot_write.addr];
+  }
+
+  return *((uint8_t *)addr);
+}
+
+bool bootDecompWrite(uint8_t data)
+{
+  if (bootIsFlashRange(boot_decomp.stage_addr + boot_decomp.stage_len, 1) != true)
+  {
+    return false;
+  }
+
+  boot_stage_buf[boot_decomp.stage_len++] = data;
+
+  if (boot_decomp.stage_len >= BOOT_STAGE_LENGTH)
+  {
+    bootDecompStage();
+  }
+
+  return true;
+}
+
+void bootDecompStage(void)
+{
+  if (boot_decomp.stage_len == 0)
+  {
+    return;
+  }
+
+  // 모아진 데이터를 Write 파이프라인으로 넘긴다.
+  //
+  bootWriteFlush();
+
+  memcpy(boot_write.buf, boot_stage_buf, boot_decomp.stage_len);
+  boot_write.addr    = boot_decomp.stage_addr;
+  boot_write.length  = boot_decomp.stage_len;
+  boot_write.index   = 0;
+  boot_write.is_busy = true;
+
+  boot_decomp.stage_addr += boot_decomp.stage_len;
+  boot_decomp.stage_len   = 0;
+}
+
+void bootDecompEnd(void)
+{
+  boot_decomp.is_failed = false;
+
+  if (boot_decomp.is_active != true)
+  {
+    return;
+  }
+
+  if (lzIsDone(&boot_decomp.lz) != true)
+  {
+    boot_decomp.err_code = BOOT_ERR_DECOMPRESS;
+  }
+
+  bootDecompStage();
+  boot_decomp.is_active = false;
+}
+
+bool bootDeltaRead(uint32_t offset, uint8_t *p_data)
+{
+  uint32_t addr;
+
+
+  addr = boot_delta.addr_start + offset;
+
+  // 이미 새로 쓴 섹터는 참조할 수 없다.
+  //
+  if (offset >= boot_delta.old_length || addr < boot_delta.stage_addr)
+  {
+    return false;
+  }
+
+  *p_data = *((uint8_t *)addr);
+
+  return true;
+}
+
+bool bootDeltaWrite(uint8_t data)
+{
+  if (boot_delta.delta.out_len >= boot_delta.new_length)
+  {
+    return false;
+  }
+
+  boot_stage_buf[boot_delta.stage_len++] = data;
+
+  if (boot_delta.stage_len >= BOOT_STAGE_LENGTH)
+  {
+    bootDeltaStage();
+  }
+
+  return true;
+}
+
+void bootDeltaStage(void)
+{
+  uint32_t offset = 0;
+
+
+  if (boot_delta.stage_len == 0)
+  {
+    return;
+  }
+
+  bootWriteFlush();
+
+  // 내용이 같은 섹터는 지우지 않고 그대로 둔다.
+  //
+  if (memcmp((void *)boot_delta.stage_addr, boot_stage_buf, boot_delta.stage_len) != 0)
+  {
+    if (flashErase(boot_delta.stage_addr, boot_delta.stage_len) != true)
+    {
+      boot_delta.err_code = BOOT_ERR_FLASH_ERASE;
+    }
+    else
+    {
+      // 태그의 magic 은 패치가 모두 끝난 후에 Write.
+      //
+      if (boot_delta.stage_addr == FLASH_ADDR_TAG && boot_delta.stage_len >= 4)
+      {
+        memcpy(&boot_delta.tag_magic, boot_stage_buf, 4);
+        boot_delta.is_tag = true;
+        offset = 4;
+      }
+
+      memcpy(boot_write.buf, &boot_stage_buf[offset], boot_delta.stage_len - offset);
+      boot_write.addr    = boot_delta.stage_addr + offset;
+      boot_write.length  = boot_delta.stage_len - offset;
+      boot_write.index   = 0;
+      boot_write.is_busy = true;
+    }
+  }
+
+  boot_delta.stage_addr += boot_delta.stage_len;
+  boot_delta.stage_len   = 0;
 }
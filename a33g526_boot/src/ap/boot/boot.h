@@ -21,15 +21,48 @@
 #define BOOT_ERR_BUF_OVF        0x06
 #define BOOT_ERR_INVALID_FW     0x07
 #define BOOT_ERR_FW_CRC         0x08
+#define BOOT_ERR_WRONG_SEQ      0x09
+#define BOOT_ERR_DECOMPRESS     0x0A
+#define BOOT_ERR_DELTA_BASE     0x0B
+#define BOOT_ERR_DELTA          0x0C
+#define BOOT_ERR_BAUD           0x0D
+
+
+#define BOOT_CAPS_WRITE_PIPE    (1<<0)    // FLASH_WRITE 응답을 Write 완료 전에 보냄
+#define BOOT_CAPS_WINDOW        (1<<1)    // SEQ 패킷을 이용한 Window 모드 지원
+#define BOOT_CAPS_COMPRESS      (1<<2)    // FLASH_WRITE_COMPRESSED 지원 (lz.h 포맷)
+#define BOOT_CAPS_DELTA         (1<<3)    // DELTA_BEGIN/WRITE/END 지원 (delta.h 포맷)
+#define BOOT_CAPS_SECTOR_CRC    (1<<4)    // FLASH_READ_CRC 지원, 같은 내용의 섹터는 Erase/Write 생략
+#define BOOT_CAPS_SET_BAUD      (1<<5)    // SET_BAUD 지원
+#define BOOT_CAPS_FLASH_READ    (1<<6)    // FLASH_READ 지원, 데이터 + CRC16 응답
+#define BOOT_CAPS_UART_STAT     (1<<7)    // READ_UART_STAT 지원, 수신 버퍼 Drop/오류 카운트
+#define BOOT_CAPS_WRITE_END     (1<<8)    // 길이 0 FLASH_WRITE 로 Write 에러와 실패 주소를 확인
+
+// Window 로 먼저 보낸 패킷은 처리 전까지 UART 수신 버퍼에 쌓이므로
+// 최대 크기 패킷이 수신 버퍼에 들어가는 개수까지만 허용. (HW_UART_RX_BUF_LENGTH 4096 이면 3)
+//
+#define BOOT_WINDOW_PACKET_LENGTH (CMD_HEADER_LENGTH + CMD_SEQ_LENGTH + CMD_MAX_DATA_LENGTH + 2)
+#define BOOT_WINDOW_MAX           (UART_RX_BUF_LENGTH / BOOT_WINDOW_PACKET_LENGTH)
+
+#ifndef BOOT_VERIFY_PARANOID_CNT
+#define BOOT_VERIFY_PARANOID_CNT  0       // 0 : 확인 기록이 있으면 CRC 생략, N : N 번째 부팅마다 CRC 전체 확인 (1 : 매번)
+#endif
 
 
 
 
 
 void bootInit(void);
+void bootUpdate(cmd_t *p_cmd);
 void bootProcessCmd(cmd_t *p_cmd);
 bool bootVerifyFw(void);
 bool bootVerifyCrc(void);
+bool bootVerifyCache(void);
+void bootVerifyCacheSave(void);
+void bootVerifyCacheClear(void);
+#ifdef _USE_CRC_BENCH
+void bootCrcBench(void);
+#endif
 void bootJumpToFw(void);
 
 #endif /* SRC_AP_BOOT_BOOT_H_ */
@@ -0,0 +1,291 @@
+/*
+ * crc.c
+ *
+ *  Created on: 2021. 8. 10.
+ *      Author: baram
+ */
+
+
+#include "crc.h"
+
+
+#if CRC_SLICE != 1 && CRC_SLICE != 4 && CRC_SLICE != 8
+#error "CRC_SLICE : 1, 4, 8"
+#endif
+
+#ifdef _USE_CRC_BENCH
+#define CRC_TABLE_COUNT       CRC_SLICE_MAX
+#else
+#define CRC_TABLE_COUNT       CRC_SLICE
+#endif
+
+
+#if CRC_SLICE == 1 || defined(_USE_CRC_BENCH)
+static void crc16UpdateBy1(uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length);
+#endif
+#if CRC_TABLE_COUNT >= 4
+static void crc16UpdateBy4(uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length);
+#endif
+#if CRC_TABLE_COUNT >= 8
+static void crc16UpdateBy8(uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length);
+#endif
+
+
+static bool is_init = false;
+
+// crc16_table[k][x] : x 뒤에 0 이 k 바이트 더 들어왔을 때의 CRC
+//
+static uint16_t crc16_table[CRC_TABLE_COUNT][256];
+
+#ifdef _USE_CRC32
+static uint32_t crc32_table[CRC_SLICE][256];
+#endif
+
+
+
+
+bool crcInit(void)
+{
+  bool ret = true;
+  uint16_t crc;
+
+
+  if (is_init == true)
+  {
+    return true;
+  }
+
+  for (int i=0; i<256; i++)
+  {
+    crc = (uint16_t)(i << 8);
+    for (int j=0; j<8; j++)
+    {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005) : (uint16_t)(crc << 1);
+    }
+    crc16_table[0][i] = crc;
+  }
+  for (int k=1; k<CRC_TABLE_COUNT; k++)
+  {
+    for (int i=0; i<256; i++)
+    {
+      crc = crc16_table[k-1][i];
+      crc16_table[k][i] = (uint16_t)(crc << 8) ^ crc16_table[0][crc >> 8];
+    }
+  }
+
+#ifdef _USE_CRC32
+  uint32_t crc32;
+
+  for (int i=0; i<256; i++)
+  {
+    crc32 = (uint32_t)i;
+    for (int j=0; j<8; j++)
+    {
+      crc32 = (crc32 & 1) ? ((crc32 >> 1) ^ 0xEDB88320) : (crc32 >> 1);
+    }
+    crc32_table[0][i] = crc32;
+  }
+  for (int k=1; k<CRC_SLICE; k++)
+  {
+    for (int i=0; i<256; i++)
+    {
+      crc32 = crc32_table[k-1][i];
+      crc32_table[k][i] = (crc32 >> 8) ^ crc32_table[0][crc32 & 0xFF];
+    }
+  }
+#endif
+
+  is_init = true;
+
+  return ret;
+}
+
+void crcUpdate(uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length)
+{
+#if CRC_SLICE == 8
+  crc16UpdateBy8(p_crc_cur, p_data, length);
+#elif CRC_SLICE == 4
+  crc16UpdateBy4(p_crc_cur, p_data, length);
+#else
+  crc16UpdateBy1(p_crc_cur, p_data, length);
+#endif
+}
+
+#ifdef _USE_CRC_BENCH
+void crcUpdateSlice(uint8_t slice, uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length)
+{
+  switch(slice)
+  {
+    case 8:
+      crc16UpdateBy8(p_crc_cur, p_data, length);
+      break;
+
+    case 4:
+      crc16UpdateBy4(p_crc_cur, p_data, length);
+      break;
+
+    default:
+      crc16UpdateBy1(p_crc_cur, p_data, length);
+      break;
+  }
+}
+#endif
+
+#if CRC_SLICE == 1 || defined(_USE_CRC_BENCH)
+void crc16UpdateBy1(uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length)
+{
+  uint16_t crc;
+
+
+  crc = *p_crc_cur;
+
+  for (uint32_t i=0; i<length; i++)
+  {
+    crc = (uint16_t)(crc << 8) ^ crc16_table[0][(crc >> 8) ^ p_data[i]];
+  }
+
+  *p_crc_cur = crc;
+}
+#endif
+
+#if CRC_TABLE_COUNT >= 4
+void crc16UpdateBy4(uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length)
+{
+  uint16_t crc;
+  uint32_t data;
+
+
+  crc = *p_crc_cur;
+
+  // 4바이트 정렬될 때까지는 1바이트씩 처리
+  //
+  while(length > 0 && ((uintptr_t)p_data & 0x03) != 0)
+  {
+    crc = (uint16_t)(crc << 8) ^ crc16_table[0][(crc >> 8) ^ *p_data++];
+    length--;
+  }
+
+  // 워드로 읽어서 4바이트씩 처리 (Little Endian)
+  //
+  while(length >= 4)
+  {
+    data = *(const uint32_t *)p_data;
+
+    crc = crc16_table[3][((crc >> 8) ^ (data >>  0)) & 0xFF] ^
+          crc16_table[2][((crc >> 0) ^ (data >>  8)) & 0xFF] ^
+          crc16_table[1][(data >> 16) & 0xFF] ^
+          crc16_table[0][(data >> 24) & 0xFF];
+
+    p_data += 4;
+    length -= 4;
+  }
+
+  while(length > 0)
+  {
+    crc = (uint16_t)(crc << 8) ^ crc16_table[0][(crc >> 8) ^ *p_data++];
+    length--;
+  }
+
+  *p_crc_cur = crc;
+}
+#endif
+
+#if CRC_TABLE_COUNT >= 8
+void crc16UpdateBy8(uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length)
+{
+  uint16_t crc;
+  uint32_t data_l;
+  uint32_t data_h;
+
+
+  crc = *p_crc_cur;
+
+  while(length > 0 && ((uintptr_t)p_data & 0x03) != 0)
+  {
+    crc = (uint16_t)(crc << 8) ^ crc16_table[0][(crc >> 8) ^ *p_data++];
+    length--;
+  }
+
+  while(length >= 8)
+  {
+    data_l = *(const uint32_t *)&p_data[0];
+    data_h = *(const uint32_t *)&p_data[4];
+
+    crc = crc16_table[7][((crc >> 8) ^ (data_l >>  0)) & 0xFF] ^
+          crc16_table[6][((crc >> 0) ^ (data_l >>  8)) & 0xFF] ^
+          crc16_table[5][(data_l >> 16) & 0xFF] ^
+          crc16_table[4][(data_l >> 24) & 0xFF] ^
+          crc16_table[3][(data_h >>  0) & 0xFF] ^
+          crc16_table[2][(data_h >>  8) & 0xFF] ^
+          crc16_table[1][(data_h >> 16) & 0xFF] ^
+          crc16_table[0][(data_h >> 24) & 0xFF];
+
+    p_data += 8;
+    length -= 8;
+  }
+
+  while(length > 0)
+  {
+    crc = (uint16_t)(crc << 8) ^ crc16_table[0][(crc >> 8) ^ *p_data++];
+    length--;
+  }
+
+  *p_crc_cur = crc;
+}
+#endif
+
+#ifdef _USE_CRC32
+void crc32Update(uint32_t *p_crc_cur, const uint8_t *p_data, uint32_t length)
+{
+  uint32_t crc;
+
+
+  crc = *p_crc_cur;
+
+#if CRC_SLICE >= 4
+  while(length > 0 && ((uintptr_t)p_data & 0x03) != 0)
+  {
+    crc = (crc >> 8) ^ crc32_table[0][(crc ^ *p_data++) & 0xFF];
+    length--;
+  }
+
+  while(length >= CRC_SLICE)
+  {
+    uint32_t data;
+
+#if CRC_SLICE == 8
+    data = *(const uint32_t *)&p_data[4];
+    crc ^= *(const uint32_t *)&p_data[0];
+
+    crc = crc32_table[7][(crc  >>  0) & 0xFF] ^
+          crc32_table[6][(crc  >>  8) & 0xFF] ^
+          crc32_table[5][(crc  >> 16) & 0xFF] ^
+          crc32_table[4][(crc  >> 24) & 0xFF] ^
+          crc32_table[3][(data >>  0) & 0xFF] ^
+          crc32_table[2][(data >>  8) & 0xFF] ^
+          crc32_table[1][(data >> 16) & 0xFF] ^
+          crc32_table[0][(data >> 24) & 0xFF];
+#else
+    data = *(const uint32_t *)p_data;
+    crc ^= data;
+
+    crc = crc32_table[3][(crc >>  0) & 0xFF] ^
+          crc32_table[2][(crc >>  8) & 0xFF] ^
+          crc32_table[1][(crc >> 16) & 0xFF] ^
+          crc32_table[0][(crc >> 24) & 0xFF];
+#endif
+
+    p_data += CRC_SLICE;
+    length -= CRC_SLICE;
+  }
+#endif
+
+  while(length > 0)
+  {
+    crc = (crc >> 8) ^ crc32_table[0][(crc ^ *p_data++) & 0xFF];
+    length--;
+  }
+
+  *p_crc_cur = crc;
+}
+#endif
@@ -0,0 +1,52 @@
+/*
+ * crc.h
+ *
+ *  Created on: 2021. 8. 10.
+ *      Author: baram
+ */
+
+#ifndef SRC_COMMON_CORE_CRC_H_
+#define SRC_COMMON_CORE_CRC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "def.h"
+
+
+//
+// CRC16 : poly 0x8005, init 0, MSB first (utilUpdateCrc() 와 같은 결과)
+// CRC32 : poly 0xEDB88320 (reflected), init/xorout 은 호출하는 쪽에서 처리
+//
+// 테이블은 crcInit() 에서 RAM 에 만든다. (Flash 사용 없음, RAM 512 x CRC_SLICE 바이트)
+//
+#ifndef CRC_SLICE
+#define CRC_SLICE             4         // 한번에 처리하는 바이트 수 : 1, 4, 8
+#endif
+
+//#define _USE_CRC32                    // CRC32 사용, RAM 1024 x CRC_SLICE 바이트 추가
+//#define _USE_CRC_BENCH                // 1/4/8 바이트 방식을 모두 넣어서 비교
+
+
+#define CRC_SLICE_MAX         8
+
+
+bool crcInit(void);
+void crcUpdate(uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length);
+
+#ifdef _USE_CRC32
+void crc32Update(uint32_t *p_crc_cur, const uint8_t *p_data, uint32_t length);
+#endif
+
+#ifdef _USE_CRC_BENCH
+void crcUpdateSlice(uint8_t slice, uint16_t *p_crc_cur, const uint8_t *p_data, uint32_t length);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_COMMON_CORE_CRC_H_ */
@@ -0,0 +1,121 @@
+/*
+ * delta.c
+ *
+ *  Created on: 2021. 8. 9.
+ *      Author: baram
+ */
+
+
+#include "delta.h"
+
+
+#define DELTA_STATE_TOKEN       0
+#define DELTA_STATE_INSERT      1
+#define DELTA_STATE_OFFSET      2
+#define DELTA_STATE_LENGTH      3
+
+
+
+
+bool deltaCreate(delta_t *p_delta, bool (*read)(uint32_t offset, uint8_t *p_data), bool (*write)(uint8_t data))
+{
+  bool ret = true;
+
+  p_delta->state   = DELTA_STATE_TOKEN;
+  p_delta->index   = 0;
+  p_delta->offset  = 0;
+  p_delta->count   = 0;
+  p_delta->out_len = 0;
+  p_delta->read    = read;
+  p_delta->write   = write;
+
+  return ret;
+}
+
+bool deltaDecode(delta_t *p_delta, uint8_t *p_data, uint32_t length)
+{
+  bool ret = true;
+  uint8_t rx_data;
+  uint8_t old_data;
+
+
+  for (int i=0; i<length; i++)
+  {
+    rx_data = p_data[i];
+
+    switch(p_delta->state)
+    {
+      case DELTA_STATE_TOKEN:
+        if (rx_data == DELTA_TOKEN_COPY)
+        {
+          p_delta->index  = 0;
+          p_delta->offset = 0;
+          p_delta->count  = 0;
+          p_delta->state  = DELTA_STATE_OFFSET;
+        }
+        else if ((rx_data & DELTA_TOKEN_COPY) == 0)
+        {
+          p_delta->count = (rx_data & 0x7F) + 1;
+          p_delta->state = DELTA_STATE_INSERT;
+        }
+        else
+        {
+          return false;
+        }
+        break;
+
+      case DELTA_STATE_INSERT:
+        if (p_delta->write(rx_data) != true)
+        {
+          return false;
+        }
+        p_delta->out_len++;
+        p_delta->count--;
+        if (p_delta->count == 0)
+        {
+          p_delta->state = DELTA_STATE_TOKEN;
+        }
+        break;
+
+      case DELTA_STATE_OFFSET:
+        p_delta->offset |= (rx_data << (8 * p_delta->index));
+        p_delta->index++;
+        if (p_delta->index == 3)
+        {
+          p_delta->index = 0;
+          p_delta->state = DELTA_STATE_LENGTH;
+        }
+        break;
+
+      case DELTA_STATE_LENGTH:
+        p_delta->count |= (rx_data << (8 * p_delta->index));
+        p_delta->index++;
+        if (p_delta->index < 2)
+        {
+          break;
+        }
+        p_delta->state = DELTA_STATE_TOKEN;
+
+        for (int j=0; j<p_delta->count; j++)
+        {
+          if (p_delta->read(p_delta->offset + j, &old_data) != true)
+          {
+            return false;
+          }
+          if (p_delta->write(old_data) != true)
+          {
+            return false;
+          }
+          p_delta->out_len++;
+        }
+        break;
+    }
+  }
+
+  return ret;
+}
+
+bool deltaIsDone(delta_t *p_delta)
+{
+  return (p_delta->state == DELTA_STATE_TOKEN) ? true:false;
+}
@@ -0,0 +1,73 @@
+/*
+ * delta.h
+ *
+ *  Created on: 2021. 8. 9.
+ *      Author: baram
+ */
+
+#ifndef SRC_COMMON_CORE_DELTA_H_
+#define SRC_COMMON_CORE_DELTA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "def.h"
+
+
+//
+// 패치 포맷
+//
+//   TOKEN [DATA]
+//
+//   TOKEN & 0x80 == 0 : Insert, (TOKEN & 0x7F) + 1 바이트의 데이터가 뒤따름
+//   TOKEN == 0x80     : Copy,   이전 이미지의 OFFSET(3바이트) 에서 LENGTH(2바이트) 만큼 복사
+//                               (Little Endian, OFFSET 은 패치 영역 시작부터의 위치)
+//
+//   패치는 섹터 순서대로 덮어쓰므로, Copy 는 현재 쓰고 있는 섹터 이후의
+//   이전 이미지만 참조할 수 있다.
+//
+#define DELTA_INSERT_MAX      128
+#define DELTA_COPY_MAX        0xFFFF
+#define DELTA_OFFSET_MAX      0xFFFFFF
+
+#define DELTA_TOKEN_COPY      0x80
+
+
+#define DELTA_FILE_MAGIC      0x31544C44    // "DLT1"
+
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t old_length;
+  uint32_t new_length;
+  uint16_t old_crc;               // utilUpdateCrc() 로 계산한 이전 이미지 CRC
+  uint16_t reserved;
+} delta_file_header_t;            // 호스트 패치 파일의 헤더, 뒤에 패치 데이터가 이어짐
+
+
+typedef struct
+{
+  uint8_t  state;
+  uint8_t  index;
+  uint32_t offset;
+  uint32_t count;
+  uint32_t out_len;
+
+  bool (*read)(uint32_t offset, uint8_t *p_data);   // 이전 이미지를 읽음
+  bool (*write)(uint8_t data);                      // 데이터 출력
+} delta_t;
+
+
+bool deltaCreate(delta_t *p_delta, bool (*read)(uint32_t offset, uint8_t *p_data), bool (*write)(uint8_t data));
+bool deltaDecode(delta_t *p_delta, uint8_t *p_data, uint32_t length);
+bool deltaIsDone(delta_t *p_delta);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_COMMON_CORE_DELTA_H_ */
@@ -0,0 +1,105 @@
+/*
+ * lz.c
+ *
+ *  Created on: 2021. 8. 8.
+ *      Author: baram
+ */
+
+
+#include "lz.h"
+
+
+#define LZ_STATE_TOKEN        0
+#define LZ_STATE_LITERAL      1
+#define LZ_STATE_OFFSET_L     2
+#define LZ_STATE_OFFSET_H     3
+
+
+
+
+bool lzCreate(lz_t *p_lz, uint8_t (*read)(uint32_t index), bool (*write)(uint8_t data))
+{
+  bool ret = true;
+
+  p_lz->state   = LZ_STATE_TOKEN;
+  p_lz->count   = 0;
+  p_lz->offset  = 0;
+  p_lz->out_len = 0;
+  p_lz->read    = read;
+  p_lz->write   = write;
+
+  return ret;
+}
+
+bool lzDecode(lz_t *p_lz, uint8_t *p_data, uint32_t length)
+{
+  bool ret = true;
+  uint8_t rx_data;
+
+
+  for (int i=0; i<length; i++)
+  {
+    rx_data = p_data[i];
+
+    switch(p_lz->state)
+    {
+      case LZ_STATE_TOKEN:
+        if (rx_data & LZ_TOKEN_MATCH)
+        {
+          p_lz->count = (rx_data & 0x7F) + LZ_MATCH_MIN;
+          p_lz->state = LZ_STATE_OFFSET_L;
+        }
+        else
+        {
+          p_lz->count = (rx_data & 0x7F) + 1;
+          p_lz->state = LZ_STATE_LITERAL;
+        }
+        break;
+
+      case LZ_STATE_LITERAL:
+        if (p_lz->write(rx_data) != true)
+        {
+          return false;
+        }
+        p_lz->out_len++;
+        p_lz->count--;
+        if (p_lz->count == 0)
+        {
+          p_lz->state = LZ_STATE_TOKEN;
+        }
+        break;
+
+      case LZ_STATE_OFFSET_L:
+        p_lz->offset = rx_data;
+        p_lz->state  = LZ_STATE_OFFSET_H;
+        break;
+
+      case LZ_STATE_OFFSET_H:
+        p_lz->offset |= (rx_data << 8);
+        p_lz->state   = LZ_STATE_TOKEN;
+
+        // 출력한 데이터 밖을 참조하면 에러.
+        if (p_lz->offset == 0 || p_lz->offset > p_lz->out_len)
+        {
+          return false;
+        }
+
+        for (int j=0; j<p_lz->count; j++)
+        {
+          if (p_lz->write(p_lz->read(p_lz->out_len - p_lz->offset)) != true)
+          {
+            return false;
+          }
+          p_lz->out_len++;
+        }
+        break;
+    }
+  }
+
+  return ret;
+}
+
+bool lzIsDone(lz_t *p_lz)
+{
+  return (p_lz->state == LZ_STATE_TOKEN) ? true:false;
+}
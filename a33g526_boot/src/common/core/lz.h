@@ -0,0 +1,57 @@
+/*
+ * lz.h
+ *
+ *  Created on: 2021. 8. 8.
+ *      Author: baram
+ */
+
+#ifndef SRC_COMMON_CORE_LZ_H_
+#define SRC_COMMON_CORE_LZ_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "def.h"
+
+
+//
+// 압축 포맷
+//
+//   TOKEN [DATA]
+//
+//   TOKEN & 0x80 == 0 : Literal, (TOKEN & 0x7F) + 1 바이트의 데이터가 뒤따름
+//   TOKEN & 0x80 != 0 : Match,   (TOKEN & 0x7F) + 3 바이트를 OFFSET 만큼 앞의 출력에서 복사
+//                                OFFSET 은 2바이트 (Little Endian, 1 ~ 65535)
+//
+#define LZ_LITERAL_MAX      128
+#define LZ_MATCH_MIN        3
+#define LZ_MATCH_MAX        130
+#define LZ_OFFSET_MAX       0xFFFF
+
+#define LZ_TOKEN_MATCH      0x80
+
+
+typedef struct
+{
+  uint8_t  state;
+  uint16_t count;
+  uint16_t offset;
+  uint32_t out_len;
+
+  uint8_t (*read)(uint32_t index);      // 이미 출력한 데이터를 읽음
+  bool    (*write)(uint8_t data);       // 데이터 출력
+} lz_t;
+
+
+bool lzCreate(lz_t *p_lz, uint8_t (*read)(uint32_t index), bool (*write)(uint8_t data));
+bool lzDecode(lz_t *p_lz, uint8_t *p_data, uint32_t length);
+bool lzIsDone(lz_t *p_lz);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_COMMON_CORE_LZ_H_ */
@@ -10,6 +10,22 @@
 
 
 
+// 2의 거듭제곱 길이 (SPSC 모드)
+//
+// in/out 은 계속 증가하는 값으로 쓰고 (mask 로 위치 계산), in 은 쓰는 쪽, out 은 읽는 쪽만 변경한다.
+// 상대방이 변경하는 값은 acquire 로 읽고, 자신의 값은 데이터 복사 후에 release 로 쓴다.
+// (ISR 1개 <-> 메인루프 1개 사이에서 인터럽트 금지 없이 사용 가능)
+//
+#define QBUFFER_LOAD(p)           __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define QBUFFER_STORE(p, v)       __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+
+static bool     qbufferIsPow2(uint32_t length);
+static uint32_t qbufferWritePow2(qbuffer_t *p_node, uint8_t *p_data, uint32_t length);
+static uint32_t qbufferReadPow2(qbuffer_t *p_node, uint8_t *p_data, uint32_t length);
+
+
+
 
 
 void qbufferInit(void)
@@ -25,6 +41,7 @@ bool qbufferCreate(qbuffer_t *p_node, uint8_t *p_buf, uint32_t length)
   p_node->out   = 0;
   p_node->len   = length;
   p_node->size  = 1;
+  p_node->mask  = qbufferIsPow2(length) ? (length - 1) : 0;
   p_node->p_buf = p_buf;
 
   return ret;
@@ -38,6 +55,7 @@ bool qbufferCreateBySize(qbuffer_t *p_node, uint8_t *p_buf, uint32_t size, uint3
   p_node->out   = 0;
   p_node->len   = length;
   p_node->size  = size;
+  p_node->mask  = qbufferIsPow2(length) ? (length - 1) : 0;
   p_node->p_buf = p_buf;
 
   return ret;
@@ -49,6 +67,11 @@ bool qbufferWrite(qbuffer_t *p_node, uint8_t *p_data, uint32_t length)
   uint32_t next_in;
 
 
+  if (p_node->mask != 0)
+  {
+    return (qbufferWritePow2(p_node, p_data, length) == length) ? true:false;
+  }
+
   for (int i=0; i<length; i++)
   {
     next_in = (p_node->in + 1) % p_node->len;
@@ -83,6 +106,11 @@ bool qbufferRead(qbuffer_t *p_node, uint8_t *p_data, uint32_t length)
   bool ret = true;
 
 
+  if (p_node->mask != 0)
+  {
+    return (qbufferReadPow2(p_node, p_data, length) == length) ? true:false;
+  }
+
   for (int i=0; i<length; i++)
   {
     if (p_node->p_buf != NULL && p_data != NULL)
@@ -112,13 +140,149 @@ bool qbufferRead(qbuffer_t *p_node, uint8_t *p_data, uint32_t length)
   return ret;
 }
 
+// 읽을 수 있는 만큼 최대 length 개를 복사하고 읽은 개수를 리턴
+// 버퍼 끝에서 나뉘는 경우만 2번에 나눠서 복사한다.
+//
+uint32_t qbufferReadBulk(qbuffer_t *p_node, uint8_t *p_data, uint32_t length)
+{
+  uint32_t in;
+  uint32_t out;
+  uint32_t count;
+  uint32_t seg_len;
+
+
+  if (p_node->mask != 0)
+  {
+    return qbufferReadPow2(p_node, p_data, length);
+  }
+
+  in    = p_node->in;
+  out   = p_node->out;
+  count = (in >= out) ? (in - out) : (p_node->len - out + in);
+  count = min(count, length);
+
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  if (p_node->p_buf != NULL && p_data != NULL)
+  {
+    seg_len = min(count, p_node->len - out);
+
+    memcpy(p_data, &p_node->p_buf[out*p_node->size], seg_len*p_node->size);
+    if (count > seg_len)
+    {
+      memcpy(&p_data[seg_len*p_node->size], &p_node->p_buf[0], (count - seg_len)*p_node->size);
+    }
+  }
+
+  p_node->out = (out + count) % p_node->len;
+
+  return count;
+}
+
+// 버퍼 안에서 연속으로 읽을 수 있는 영역, 처리한 만큼 qbufferConsume() 호출
+//
+uint32_t qbufferGetReadSpan(qbuffer_t *p_node, uint8_t **pp_data)
+{
+  uint32_t in;
+  uint32_t out;
+  uint32_t ret;
+
+
+  if (p_node->mask != 0)
+  {
+    in  = QBUFFER_LOAD(&p_node->in);
+    out = p_node->out;
+    ret = min(in - out, p_node->len - (out & p_node->mask));
+    out = out & p_node->mask;
+  }
+  else
+  {
+    in  = p_node->in;
+    out = p_node->out;
+    ret = (in >= out) ? (in - out) : (p_node->len - out);
+  }
+
+  *pp_data = &p_node->p_buf[out*p_node->size];
+
+  return ret;
+}
+
+void qbufferConsume(qbuffer_t *p_node, uint32_t length)
+{
+  if (p_node->mask != 0)
+  {
+    QBUFFER_STORE(&p_node->out, p_node->out + length);
+    return;
+  }
+
+  p_node->out = (p_node->out + length) % p_node->len;
+}
+
+// 버퍼 안에서 연속으로 쓸 수 있는 영역, 채운 만큼 qbufferProduce() 호출
+//
+uint32_t qbufferGetWriteSpan(qbuffer_t *p_node, uint8_t **pp_data)
+{
+  uint32_t in;
+  uint32_t out;
+  uint32_t ret;
+
+
+  if (p_node->mask != 0)
+  {
+    in  = p_node->in;
+    out = QBUFFER_LOAD(&p_node->out);
+    ret = min(p_node->len - (in - out), p_node->len - (in & p_node->mask));
+    in  = in & p_node->mask;
+  }
+  else
+  {
+    // 이전 방식은 in 이 out 바로 앞까지만 쓸 수 있다.
+    in  = p_node->in;
+    out = p_node->out;
+    if (in >= out)
+    {
+      ret = p_node->len - in - ((out == 0) ? 1 : 0);
+    }
+    else
+    {
+      ret = out - in - 1;
+    }
+  }
+
+  *pp_data = &p_node->p_buf[in*p_node->size];
+
+  return ret;
+}
+
+void qbufferProduce(qbuffer_t *p_node, uint32_t length)
+{
+  if (p_node->mask != 0)
+  {
+    QBUFFER_STORE(&p_node->in, p_node->in + length);
+    return;
+  }
+
+  p_node->in = (p_node->in + length) % p_node->len;
+}
+
 uint8_t *qbufferPeekWrite(qbuffer_t *p_node)
 {
+  if (p_node->mask != 0)
+  {
+    return &p_node->p_buf[(p_node->in & p_node->mask)*p_node->size];
+  }
   return &p_node->p_buf[p_node->in*p_node->size];
 }
 
 uint8_t *qbufferPeekRead(qbuffer_t *p_node)
 {
+  if (p_node->mask != 0)
+  {
+    return &p_node->p_buf[(p_node->out & p_node->mask)*p_node->size];
+  }
   return &p_node->p_buf[p_node->out*p_node->size];
 }
 
@@ -126,15 +290,141 @@ uint8_t *qbufferPeekRead(qbuffer_t *p_node)
 uint32_t qbufferAvailable(qbuffer_t *p_node)
 {
   uint32_t ret;
+  uint32_t in;
+  uint32_t out;
 
 
-  ret = (p_node->in - p_node->out) % p_node->len;
+  if (p_node->mask != 0)
+  {
+    in  = QBUFFER_LOAD(&p_node->in);
+    out = QBUFFER_LOAD(&p_node->out);
+    return in - out;
+  }
+
+  in  = p_node->in;
+  out = p_node->out;
+  ret = (in >= out) ? (in - out) : (p_node->len - out + in);
 
   return ret;
 }
 
+// 더 쓸 수 있는 개수, SPSC 모드는 length 개, 이전 방식은 length - 1 개까지 사용
+//
+uint32_t qbufferFree(qbuffer_t *p_node)
+{
+  uint32_t in;
+  uint32_t out;
+
+
+  if (p_node->mask != 0)
+  {
+    in  = QBUFFER_LOAD(&p_node->in);
+    out = QBUFFER_LOAD(&p_node->out);
+    return p_node->len - (in - out);
+  }
+
+  return (p_node->len - 1) - qbufferAvailable(p_node);
+}
+
 void qbufferFlush(qbuffer_t *p_node)
 {
+  // SPSC 모드는 읽는 쪽에서 out 만 옮겨서 비운다.
+  //
+  if (p_node->mask != 0)
+  {
+    QBUFFER_STORE(&p_node->out, QBUFFER_LOAD(&p_node->in));
+    return;
+  }
+
   p_node->in  = 0;
   p_node->out = 0;
 }
+
+bool qbufferIsPow2(uint32_t length)
+{
+  return (length >= 2 && (length & (length - 1)) == 0) ? true:false;
+}
+
+uint32_t qbufferWritePow2(qbuffer_t *p_node, uint8_t *p_data, uint32_t length)
+{
+  uint32_t in;
+  uint32_t out;
+  uint32_t index;
+  uint32_t count;
+  uint32_t seg_len;
+
+
+  in    = p_node->in;
+  out   = QBUFFER_LOAD(&p_node->out);
+  count = min(length, p_node->len - (in - out));
+
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  if (p_node->p_buf != NULL && p_data != NULL)
+  {
+    index   = in & p_node->mask;
+    seg_len = min(count, p_node->len - index);
+
+    if (p_node->size == 1 && count == 1)
+    {
+      p_node->p_buf[index] = p_data[0];
+    }
+    else
+    {
+      memcpy(&p_node->p_buf[index*p_node->size], p_data, seg_len*p_node->size);
+      if (count > seg_len)
+      {
+        memcpy(&p_node->p_buf[0], &p_data[seg_len*p_node->size], (count - seg_len)*p_node->size);
+      }
+    }
+  }
+
+  QBUFFER_STORE(&p_node->in, in + count);
+
+  return count;
+}
+
+uint32_t qbufferReadPow2(qbuffer_t *p_node, uint8_t *p_data, uint32_t length)
+{
+  uint32_t in;
+  uint32_t out;
+  uint32_t index;
+  uint32_t count;
+  uint32_t seg_len;
+
+
+  out   = p_node->out;
+  in    = QBUFFER_LOAD(&p_node->in);
+  count = min(length, in - out);
+
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  if (p_node->p_buf != NULL && p_data != NULL)
+  {
+    index   = out & p_node->mask;
+    seg_len = min(count, p_node->len - index);
+
+    if (p_node->size == 1 && count == 1)
+    {
+      p_data[0] = p_node->p_buf[index];
+    }
+    else
+    {
+      memcpy(p_data, &p_node->p_buf[index*p_node->size], seg_len*p_node->size);
+      if (count > seg_len)
+      {
+        memcpy(&p_data[seg_len*p_node->size], &p_node->p_buf[0], (count - seg_len)*p_node->size);
+      }
+    }
+  }
+
+  QBUFFER_STORE(&p_node->out, out + count);
+
+  return count;
+}
@@ -23,19 +23,34 @@ typedef struct
   uint32_t out;
   uint32_t len;
   uint32_t size;
+  uint32_t mask;                // 0 이 아니면 2의 거듭제곱 길이 (SPSC 모드)
 
   uint8_t *p_buf;
 } qbuffer_t;
 
+//
+// length 가 2의 거듭제곱이면 SPSC 모드로 동작
+//  - 나머지 연산 없이 mask 로 위치 계산, 전체 length 개를 모두 사용
+//  - 쓰는 쪽 1개(ISR 등), 읽는 쪽 1개 사이에서 인터럽트 금지 없이 사용 가능
+//  - 여러 개를 한번에 쓰고 읽을 때는 memcpy 로 복사
+// 그 외의 길이는 이전 방식 (length - 1 개 사용, 동시 접근 보장 안됨)
+//
+
 
 void     qbufferInit(void);
 bool     qbufferCreate(qbuffer_t *p_node, uint8_t *p_buf, uint32_t length);
 bool     qbufferCreateBySize(qbuffer_t *p_node, uint8_t *p_buf, uint32_t size, uint32_t length);
 bool     qbufferWrite(qbuffer_t *p_node, uint8_t *p_data, uint32_t length);
 bool     qbufferRead(qbuffer_t *p_node, uint8_t *p_data, uint32_t length);
+uint32_t qbufferReadBulk(qbuffer_t *p_node, uint8_t *p_data, uint32_t length);
+uint32_t qbufferGetReadSpan(qbuffer_t *p_node, uint8_t **pp_data);
+void     qbufferConsume(qbuffer_t *p_node, uint32_t length);
+uint32_t qbufferGetWriteSpan(qbuffer_t *p_node, uint8_t **pp_data);
+void     qbufferProduce(qbuffer_t *p_node, uint32_t length);
 uint8_t *qbufferPeekWrite(qbuffer_t *p_node);
 uint8_t *qbufferPeekRead(qbuffer_t *p_node);
 uint32_t qbufferAvailable(qbuffer_t *p_node);
+uint32_t qbufferFree(qbuffer_t *p_node);
 void     qbufferFlush(qbuffer_t *p_node);
 
 
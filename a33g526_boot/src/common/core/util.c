@@ -11,7 +11,7 @@
 
 
 
-volatile const unsigned short util_crc_table[256] = {0x0000,
+const unsigned short util_crc_table[256] = {0x0000,
                                 0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
                                 0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027,
                                 0x0022, 0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D,
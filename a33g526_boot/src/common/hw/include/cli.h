@@ -13,7 +13,6 @@
 
 #ifdef _USE_HW_CLI
 
-#define CLI_CMD_LIST_MAX      HW_CLI_CMD_LIST_MAX
 #define CLI_CMD_NAME_MAX      HW_CLI_CMD_NAME_MAX
 
 #define CLI_LINE_HIS_MAX      HW_CLI_LINE_HIS_MAX
@@ -33,17 +32,48 @@ typedef struct
   bool     (*isStr)(uint8_t index, char *p_str);
 } cli_args_t;
 
+typedef struct
+{
+  const char *cmd_str;
+  void      (*cmd_func)(cli_args_t *);
+} cli_cmd_t;
+
+typedef struct
+{
+  uint32_t addr;
+  uint32_t index;
+  uint32_t count;
+} cli_job_t;
+
+
+// 명령어는 ROM 의 cli_cmd 섹션에 모인다. 섹션 이름(cli_cmd.이름)으로 링크할 때 정렬되어
+// 이진 탐색으로 찾는다. 이름은 소문자 C 식별자로 사용.
+//
+#define CLI_CMD_ADD(name, func) \
+  static const cli_cmd_t cli_cmd_##name __attribute__((section("cli_cmd." #name), used)) = {#name, func}
+
+// 출력이 긴 명령어는 cliJobStart() 로 작업을 등록하고 바로 리턴한다.
+// cliMain() 은 TX 버퍼에 CLI_JOB_TX_MIN 바이트 이상 비어 있을 때만 p_func 를 한번 호출하므로
+// p_func 는 한번에 CLI_JOB_TX_MIN 이하로 출력하고, 남은 출력이 있으면 true 를 리턴한다.
+// 작업 중 들어온 입력은 버리고 Ctrl+C 를 받으면 중단한다.
+// 단, 배치 모드는 다음 명령이 이어서 들어오므로 입력을 버리지 않고 남겨두며 (Ctrl+C 로도 중단 안됨)
+// 작업이 끝나면 "#n OK" 를 보낸 후 남은 입력으로 스크립트를 이어서 처리한다.
+//
+#define CLI_JOB_TX_MIN        256
+
 
 bool cliInit(void);
 bool cliOpen(uint8_t ch, uint32_t baud);
 bool cliOpenLog(uint8_t ch, uint32_t baud);
 bool cliMain(void);
 void cliPrintf(const char *fmt, ...);
-bool cliAdd(const char *cmd_str, void (*p_func)(cli_args_t *));
 bool cliKeepLoop(void);
 uint32_t cliAvailable(void);
 uint8_t  cliRead(void);
 uint32_t cliWrite(uint8_t *p_data, uint32_t length);
+char    *cliHexStr(char *p_str, uint32_t data, uint8_t digits);
+bool cliJobStart(bool (*p_func)(cli_job_t *p_job), uint32_t addr, uint32_t count);
+bool cliJobIsBusy(void);
 
 #endif
 
@@ -22,6 +22,9 @@
 #define CMD_DIR_M_TO_S        0
 #define CMD_DIR_S_TO_M        1
 
+#define CMD_HEADER_LENGTH     6     // STX, CMD, DIR, ERR, LEN_L, LEN_H
+#define CMD_SEQ_LENGTH        1     // CMD_STX_SEQ 패킷은 헤더 뒤에 SEQ 1바이트가 추가됨
+
 
 
 typedef struct
@@ -32,7 +35,9 @@ typedef struct
   uint16_t  length;
   uint8_t   check_sum;
   uint8_t   check_sum_recv;
-  uint8_t   buffer[CMD_MAX_DATA_LENGTH+8];
+  bool      is_seq;
+  uint8_t   seq;
+  uint8_t   buffer[CMD_MAX_DATA_LENGTH+8+CMD_SEQ_LENGTH];
   uint8_t   *data;
 } cmd_packet_t;
 
@@ -55,6 +60,7 @@ typedef struct
 void cmdInit(cmd_t *p_cmd);
 bool cmdOpen(cmd_t *p_cmd, uint8_t ch, uint32_t baud);
 bool cmdClose(cmd_t *p_cmd);
+bool cmdSetBaud(cmd_t *p_cmd, uint32_t baud);
 bool cmdReceivePacket(cmd_t *p_cmd);
 void cmdSendCmd(cmd_t *p_cmd, uint8_t cmd, uint8_t *p_data, uint32_t length);
 void cmdSendResp(cmd_t *p_cmd, uint8_t cmd, uint8_t err_code, uint8_t *p_data, uint32_t length);
@@ -22,11 +22,121 @@ extern "C" {
 #define LOG_LIST_BUF_MAX  HW_LOG_LIST_BUF_MAX
 
 
+#ifdef _USE_HW_LOG_DEFER
+#define LOG_DEFER_BUF_MAX HW_LOG_DEFER_BUF_MAX     // 워드 단위, 2의 거듭제곱
+#define LOG_DEFER_ARG_MAX 6
+
+// 포맷 문자열은 log_str 섹션에 두고 ID(섹션 offset)와 인자만 링버퍼에 넣는다.
+// 인자는 32비트 정수(%d %u %x %c)만 가능하고 %s, %f 는 사용할 수 없다.
+//
+#define logDefer(fmt, ...) \
+  do \
+  { \
+    static const char log_fmt_str[] __attribute__((section("log_str"), used)) = fmt; \
+    const uint32_t log_fmt_args[] = {0, ##__VA_ARGS__}; \
+    logDeferPush(log_fmt_str, (sizeof(log_fmt_args)/sizeof(uint32_t)) - 1, &log_fmt_args[1]); \
+  } while(0)
+#else
+#define logDefer(fmt, ...)  logPrintf(fmt, ##__VA_ARGS__)
+#endif
+
+
+#define LOG_LEVEL_NONE    0
+#define LOG_LEVEL_ERROR   1
+#define LOG_LEVEL_WARN    2
+#define LOG_LEVEL_INFO    3
+#define LOG_LEVEL_DEBUG   4
+#define LOG_LEVEL_TRACE   5
+
+// 빌드할 때 -DLOG_LEVEL=5 처럼 바꿀 수 있고, 이보다 높은 레벨의 로그는 코드에서 빠진다.
+//
+#ifndef LOG_LEVEL
+#ifdef HW_LOG_LEVEL
+#define LOG_LEVEL         HW_LOG_LEVEL
+#else
+#define LOG_LEVEL         LOG_LEVEL_INFO
+#endif
+#endif
+
+#define LOG_RATE_TIME     1000    // ms
+#define LOG_RATE_MAX      10      // 같은 위치의 로그는 LOG_RATE_TIME 동안 이 개수까지만 출력
+
+
+typedef enum
+{
+  LOG_MOD_AP,
+  LOG_MOD_HW,
+  LOG_MOD_UART,
+  LOG_MOD_FLASH,
+  LOG_MOD_CLI,
+  LOG_MOD_BOOT,
+  LOG_MOD_CMD,
+  LOG_MOD_MAX
+} LogMod_t;
+
+typedef struct
+{
+  uint32_t pre_time;
+  uint16_t count;
+  uint16_t skip_cnt;
+} log_rate_t;
+
+
+#define LOG_OUT(level, mod, fmt, ...) \
+  do \
+  { \
+    static log_rate_t log_rate; \
+    if (logCheck(&log_rate, level, mod) == true) \
+    { \
+      logDefer(fmt, ##__VA_ARGS__); \
+    } \
+  } while(0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define logError(mod, fmt, ...)   LOG_OUT(LOG_LEVEL_ERROR, mod, "[E] " fmt, ##__VA_ARGS__)
+#else
+#define logError(mod, fmt, ...)   do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define logWarn(mod, fmt, ...)    LOG_OUT(LOG_LEVEL_WARN, mod, "[W] " fmt, ##__VA_ARGS__)
+#else
+#define logWarn(mod, fmt, ...)    do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define logInfo(mod, fmt, ...)    LOG_OUT(LOG_LEVEL_INFO, mod, "[I] " fmt, ##__VA_ARGS__)
+#else
+#define logInfo(mod, fmt, ...)    do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define logDebug(mod, fmt, ...)   LOG_OUT(LOG_LEVEL_DEBUG, mod, "[D] " fmt, ##__VA_ARGS__)
+#else
+#define logDebug(mod, fmt, ...)   do {} while(0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_TRACE
+#define logTrace(mod, fmt, ...)   LOG_OUT(LOG_LEVEL_TRACE, mod, "[T] " fmt, ##__VA_ARGS__)
+#else
+#define logTrace(mod, fmt, ...)   do {} while(0)
+#endif
+
+
 bool logInit(void);
 void logEnable(void);
 void logDisable(void);
 void logBoot(uint8_t enable);
 void logPrintf(const char *fmt, ...);
+void logMain(void);
+bool logCheck(log_rate_t *p_rate, uint8_t level, uint8_t mod);
+void logSetLevel(uint8_t level);
+void logSetModule(uint8_t mod, bool enable);
+
+#ifdef _USE_HW_LOG_DEFER
+bool logDeferPush(const char *p_fmt, uint32_t argc, const uint32_t *p_args);
+void logDeferBinary(bool enable);
+#endif
 
 #endif
 
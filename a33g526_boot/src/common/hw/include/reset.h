@@ -13,14 +13,14 @@
 
 #ifdef _USE_HW_RESET
 
-#define RESET_REG_PARAM         0
-#define RESET_REG_COUNT         1
+#define RESET_LOG_BUF_MAX       HW_RESET_LOG_BUF_MAX
 
-bool resetInit(void);
 
+bool     resetInit(void);
 uint32_t resetGetCount(void);
-void resetToBoot(uint32_t timeout);
-void resetToSysBoot(void);
+uint32_t resetGetReason(void);
+void     resetToBoot(uint32_t timeout);
+void     resetLogWrite(uint8_t *p_data, uint32_t length);
 
 #endif
 
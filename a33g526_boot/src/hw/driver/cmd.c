@@ -14,6 +14,7 @@
 
 #define CMD_STX                     0x02
 #define CMD_ETX                     0x03
+#define CMD_STX_SEQ                 0x04    // 헤더에 SEQ 가 포함된 패킷 (Window 모드)
 
 
 #define CMD_STATE_WAIT_STX          0
@@ -25,6 +26,10 @@
 #define CMD_STATE_WAIT_DATA         6
 #define CMD_STATE_WAIT_CHECKSUM     7
 #define CMD_STATE_WAIT_ETX          8
+#define CMD_STATE_WAIT_SEQ          9
+
+
+static bool cmdReceiveByte(cmd_t *p_cmd, uint8_t rx_data);
 
 
 
@@ -35,8 +40,10 @@ void cmdInit(cmd_t *p_cmd)
   p_cmd->is_init = false;
   p_cmd->state = CMD_STATE_WAIT_STX;
 
-  p_cmd->rx_packet.data = &p_cmd->rx_packet.buffer[CMD_STATE_WAIT_DATA];
-  p_cmd->tx_packet.data = &p_cmd->tx_packet.buffer[CMD_STATE_WAIT_DATA];
+  p_cmd->rx_packet.data = &p_cmd->rx_packet.buffer[CMD_HEADER_LENGTH];
+  p_cmd->tx_packet.data = &p_cmd->tx_packet.buffer[CMD_HEADER_LENGTH];
+  p_cmd->rx_packet.is_seq = false;
+  p_cmd->rx_packet.seq = 0;
 }
 
 bool cmdOpen(cmd_t *p_cmd, uint8_t ch, uint32_t baud)
@@ -55,17 +62,29 @@ bool cmdClose(cmd_t *p_cmd)
   return uartClose(p_cmd->ch);
 }
 
+bool cmdSetBaud(cmd_t *p_cmd, uint32_t baud)
+{
+  bool ret;
+
+  ret = uartSetBaud(p_cmd->ch, baud);
+  if (ret == true)
+  {
+    p_cmd->baud  = baud;
+    p_cmd->state = CMD_STATE_WAIT_STX;
+  }
+
+  return ret;
+}
+
 bool cmdReceivePacket(cmd_t *p_cmd)
 {
   bool ret = false;
-  uint8_t rx_data;
+  uint8_t *p_rx;
+  uint32_t rx_len;
+  uint32_t index;
 
 
-  if (uartAvailable(p_cmd->ch) > 0)
-  {
-    rx_data = uartRead(p_cmd->ch);
-  }
-  else
+  if (uartAvailable(p_cmd->ch) == 0)
   {
     return false;
   }
@@ -76,6 +95,63 @@ bool cmdReceivePacket(cmd_t *p_cmd)
   }
   p_cmd->pre_time = millis();
 
+
+  // 수신 버퍼 안에서 바로 처리하고, 처리한 만큼만 버퍼에서 뺀다.
+  // 패킷이 완성되면 뒤의 데이터는 다음 호출에서 처리.
+  //
+  while(ret != true)
+  {
+    rx_len = uartGetReadSpan(p_cmd->ch, &p_rx);
+    if (rx_len == 0)
+    {
+      break;
+    }
+
+    index = 0;
+    while(index < rx_len && ret != true)
+    {
+      // 데이터 영역은 복사하면서 체크섬 계산
+      //
+      if (p_cmd->state == CMD_STATE_WAIT_DATA)
+      {
+        uint8_t *p_data;
+        uint8_t  check_sum;
+        uint32_t data_len;
+
+        data_len  = min(rx_len - index, p_cmd->rx_packet.length - p_cmd->index);
+        p_data    = &p_cmd->rx_packet.data[p_cmd->index];
+        check_sum = p_cmd->rx_packet.check_sum;
+
+        for (int i=0; i<data_len; i++)
+        {
+          p_data[i]  = p_rx[index + i];
+          check_sum ^= p_data[i];
+        }
+        p_cmd->rx_packet.check_sum = check_sum;
+        p_cmd->index += data_len;
+        index        += data_len;
+
+        if (p_cmd->index == p_cmd->rx_packet.length)
+        {
+          p_cmd->state = CMD_STATE_WAIT_CHECKSUM;
+        }
+        continue;
+      }
+
+      ret = cmdReceiveByte(p_cmd, p_rx[index++]);
+    }
+
+    uartConsume(p_cmd->ch, index);
+  }
+
+  return ret;
+}
+
+bool cmdReceiveByte(cmd_t *p_cmd, uint8_t rx_data)
+{
+  bool ret = false;
+
+
   switch(p_cmd->state)
   {
     case CMD_STATE_WAIT_STX:
@@ -83,9 +159,22 @@ bool cmdReceivePacket(cmd_t *p_cmd)
       {
         p_cmd->state = CMD_STATE_WAIT_CMD;
         p_cmd->rx_packet.check_sum = 0;
+        p_cmd->rx_packet.is_seq = false;
+      }
+      if (rx_data == CMD_STX_SEQ)
+      {
+        p_cmd->state = CMD_STATE_WAIT_SEQ;
+        p_cmd->rx_packet.check_sum = 0;
+        p_cmd->rx_packet.is_seq = true;
       }
       break;
 
+    case CMD_STATE_WAIT_SEQ:
+      p_cmd->rx_packet.seq = rx_data;
+      p_cmd->rx_packet.check_sum ^= rx_data;
+      p_cmd->state = CMD_STATE_WAIT_CMD;
+      break;
+
     case CMD_STATE_WAIT_CMD:
       p_cmd->rx_packet.cmd = rx_data;
       p_cmd->rx_packet.check_sum ^= rx_data;
@@ -114,7 +203,11 @@ bool cmdReceivePacket(cmd_t *p_cmd)
       p_cmd->rx_packet.length |= (rx_data << 8);
       p_cmd->rx_packet.check_sum ^= rx_data;
 
-      if (p_cmd->rx_packet.length > 0)
+      if (p_cmd->rx_packet.length > CMD_MAX_DATA_LENGTH)
+      {
+        p_cmd->state = CMD_STATE_WAIT_STX;
+      }
+      else if (p_cmd->rx_packet.length > 0)
       {
         p_cmd->index = 0;
         p_cmd->state = CMD_STATE_WAIT_DATA;
@@ -125,16 +218,6 @@ bool cmdReceivePacket(cmd_t *p_cmd)
       }
       break;
 
-    case CMD_STATE_WAIT_DATA:
-      p_cmd->rx_packet.data[p_cmd->index] = rx_data;
-      p_cmd->rx_packet.check_sum ^= rx_data;
-      p_cmd->index++;
-      if (p_cmd->index == p_cmd->rx_packet.length)
-      {
-        p_cmd->state = CMD_STATE_WAIT_CHECKSUM;
-      }
-      break;
-
     case CMD_STATE_WAIT_CHECKSUM:
       p_cmd->rx_packet.check_sum_recv = rx_data;
       p_cmd->state = CMD_STATE_WAIT_ETX;
@@ -194,7 +277,17 @@ void cmdSendResp(cmd_t *p_cmd, uint8_t cmd, uint8_t err_code, uint8_t *p_data, u
 
   index = 0;
 
-  p_cmd->tx_packet.buffer[index++] = CMD_STX;
+  // SEQ 패킷으로 받은 명령은 같은 SEQ 로 응답한다.
+  //
+  if (p_cmd->rx_packet.is_seq == true)
+  {
+    p_cmd->tx_packet.buffer[index++] = CMD_STX_SEQ;
+    p_cmd->tx_packet.buffer[index++] = p_cmd->rx_packet.seq;
+  }
+  else
+  {
+    p_cmd->tx_packet.buffer[index++] = CMD_STX;
+  }
   p_cmd->tx_packet.buffer[index++] = cmd;
   p_cmd->tx_packet.buffer[index++] = CMD_DIR_S_TO_M;
   p_cmd->tx_packet.buffer[index++] = err_code;
@@ -208,9 +301,9 @@ void cmdSendResp(cmd_t *p_cmd, uint8_t cmd, uint8_t err_code, uint8_t *p_data, u
 
   uint8_t check_sum = 0;
 
-  for (int i=0; i<length + 5; i++)
+  for (int i=1; i<index; i++)
   {
-    check_sum ^= p_cmd->tx_packet.buffer[i+1];
+    check_sum ^= p_cmd->tx_packet.buffer[i];
   }
   p_cmd->tx_packet.buffer[index++] = check_sum;
   p_cmd->tx_packet.buffer[index++] = CMD_ETX;
@@ -12,16 +12,25 @@
 #ifdef _USE_HW_FLASH
 
 
-#define FLASH_SECTOR_ADDR         0x00000000
-#define FLASH_SECTOR_MAX          256
-#define FLASH_SECTOR_SIZE         1024
-
+#define FLASH_TBL_MAX             2
 
+#define FLASH_CLI_JOB_LINE        8         // CLI 작업 한번에 출력하는 줄 수
+#define FLASH_CLI_READ_LINE       4         // flash read 는 줄당 16바이트 (약 60자)
 
 
+// 영역마다 섹터 크기가 같으므로 섹터 번호는 (addr - 시작 주소) >> sector_shift 로 구한다.
+//
+typedef struct
+{
+  uint32_t addr;
+  uint8_t  sector_shift;
+  uint16_t sector_max;
+  uint8_t  type;
+} flash_tbl_t;
 
 
-static bool flashInSector(uint16_t sector_num, uint32_t addr, uint32_t length);
+static const flash_tbl_t *flashGetTbl(uint32_t addr);
+static int  flashEraseSector(const flash_tbl_t *p_tbl, uint32_t addr);
 static void flashUnlock(void);
 static void flashLock(void);
 
@@ -29,81 +38,102 @@ static void flashLock(void);
 
 #ifdef _USE_HW_CLI
 static void cliFlash(cli_args_t *args);
+static bool cliFlashInfoJob(cli_job_t *p_job);
+static bool cliFlashReadJob(cli_job_t *p_job);
+
+CLI_CMD_ADD(flash, cliFlash);
 #endif
 
 
+static const flash_tbl_t flash_tbl[FLASH_TBL_MAX] =
+    {
+        {0x00000000, 10, 256, FLASH_TYPE_CODE},   // Code Flash 256KB, 1KB 섹터
+        {0x0F000000, 10,  32, FLASH_TYPE_DATA},   // Data Flash  32KB, 1KB 섹터
+    };
+
+
 bool flashInit(void)
 {
 
-#ifdef _USE_HW_CLI
-  cliAdd("flash", cliFlash);
-#endif
-
   return true;
 }
 
 bool flashErase(uint32_t addr, uint32_t length)
 {
-  bool ret = false;
-
-  int16_t  start_sector_num = -1;
-  uint32_t sector_count = 0;
-
+  bool ret = true;
+  const flash_tbl_t *p_tbl;
+  uint32_t offset_begin;
+  uint32_t offset_end;
 
 
-  for (int i=0; i<FLASH_SECTOR_MAX; i++)
+  // 한 영역 안의 범위만 지울 수 있다.
+  //
+  p_tbl = flashGetTbl(addr);
+  if (p_tbl == NULL || length == 0 || addr + length - 1 < addr)
   {
-    if (flashInSector(i, addr, length) == true)
-    {
-      if (start_sector_num < 0)
-      {
-        start_sector_num = i;
-      }
-      sector_count++;
-    }
+    return false;
   }
 
-
-  if (sector_count > 0)
+  offset_begin = (addr - p_tbl->addr) >> p_tbl->sector_shift;
+  offset_end   = (addr + length - 1 - p_tbl->addr) >> p_tbl->sector_shift;
+  if (offset_end >= p_tbl->sector_max)
   {
-    flashUnlock();
+    return false;
+  }
+
 
+  flashUnlock();
 
-    for (int i=0; i<sector_count; i++)
+  for (uint32_t i=offset_begin; i<=offset_end; i++)
+  {
+    if (flashEraseSector(p_tbl, p_tbl->addr + (i << p_tbl->sector_shift)) != 0)
     {
-      FLASH_Self_EraseSector(FMC, ((start_sector_num + i) * FLASH_SECTOR_SIZE));
+      ret = false;
+      break;
     }
-
-    ret = true;
-
-    flashLock();
   }
 
+  flashLock();
+
   return ret;
 }
 
 bool flashWrite(uint32_t addr, uint8_t *p_data, uint32_t length)
 {
   bool ret = true;
+  const flash_tbl_t *p_tbl;
 
 
-  if (addr%4 != 0)
+  p_tbl = flashGetTbl(addr);
+  if (addr%4 != 0 || p_tbl == NULL)
   {
     return false;
   }
 
   flashUnlock();
 
-  for (int i=0; i<length; i+=4)
+  // Data Flash 는 바이트 단위로 Program
+  //
+  if (p_tbl->type == FLASH_TYPE_DATA)
   {
-    uint32_t data;
+    for (int i=0; i<length; i++)
+    {
+      FLASH_ProgramByte(FMC, addr + i, p_data[i]);
+    }
+  }
+  else
+  {
+    for (int i=0; i<length; i+=4)
+    {
+      uint32_t data;
 
-    data  = p_data[i+0] << 0;
-    data |= p_data[i+1] << 8;
-    data |= p_data[i+2] <<16;
-    data |= p_data[i+3] <<24;
+      data  = p_data[i+0] << 0;
+      data |= p_data[i+1] << 8;
+      data |= p_data[i+2] <<16;
+      data |= p_data[i+3] <<24;
 
-    FLASH_Self_ProgramWORD(FMC, addr + i, data);
+      FLASH_Self_ProgramWORD(FMC, addr + i, data);
+    }
   }
 
   flashLock();
@@ -125,43 +155,46 @@ bool flashRead(uint32_t addr, uint8_t *p_data, uint32_t length)
   return ret;
 }
 
-bool flashInSector(uint16_t sector_num, uint32_t addr, uint32_t length)
+bool flashGetSectorInfo(uint32_t addr, flash_sector_t *p_info)
 {
-  bool ret = false;
-
-  uint32_t sector_start;
-  uint32_t sector_end;
-  uint32_t flash_start;
-  uint32_t flash_end;
-
+  const flash_tbl_t *p_tbl;
 
-  sector_start = FLASH_SECTOR_ADDR + (sector_num * FLASH_SECTOR_SIZE);
-  sector_end   = sector_start + FLASH_SECTOR_SIZE - 1;
-  flash_start  = addr;
-  flash_end    = addr + length - 1;
 
-
-  if (sector_start >= flash_start && sector_start <= flash_end)
+  p_tbl = flashGetTbl(addr);
+  if (p_tbl == NULL)
   {
-    ret = true;
+    return false;
   }
 
-  if (sector_end >= flash_start && sector_end <= flash_end)
-  {
-    ret = true;
-  }
+  p_info->index  = (addr - p_tbl->addr) >> p_tbl->sector_shift;
+  p_info->addr   = p_tbl->addr + (p_info->index << p_tbl->sector_shift);
+  p_info->length = 1 << p_tbl->sector_shift;
+  p_info->type   = p_tbl->type;
 
-  if (flash_start >= sector_start && flash_start <= sector_end)
+  return true;
+}
+
+const flash_tbl_t *flashGetTbl(uint32_t addr)
+{
+  for (int i=0; i<FLASH_TBL_MAX; i++)
   {
-    ret = true;
+    if (addr >= flash_tbl[i].addr && addr - flash_tbl[i].addr < ((uint32_t)flash_tbl[i].sector_max << flash_tbl[i].sector_shift))
+    {
+      return &flash_tbl[i];
+    }
   }
 
-  if (flash_end >= sector_start && flash_end <= sector_end)
+  return NULL;
+}
+
+int flashEraseSector(const flash_tbl_t *p_tbl, uint32_t addr)
+{
+  if (p_tbl->type == FLASH_TYPE_DATA)
   {
-    ret = true;
+    return FLASH_EraseSector(FMC, addr);
   }
 
-  return ret;
+  return FLASH_Self_EraseSector(FMC, addr);
 }
 
 void flashUnlock(void)
@@ -208,11 +241,32 @@ void cliFlash(cli_args_t *args)
 
   if (args->argc == 1 && args->isStr(0, "info") == true)
   {
-    for (int i=0; i<FLASH_SECTOR_MAX; i++)
+    uint32_t sector_cnt = 0;
+
+    for (int i=0; i<FLASH_TBL_MAX; i++)
     {
-      cliPrintf("0x%X : %dKB\n", flash_tbl[i].addr, flash_tbl[i].length/1024);
+      sector_cnt += flash_tbl[i].sector_max;
     }
+    cliJobStart(cliFlashInfoJob, 0, sector_cnt);
+    ret = true;
+  }
+
+  if (args->argc == 2 && args->isStr(0, "info") == true)
+  {
+    flash_sector_t sector;
 
+    if (flashGetSectorInfo((uint32_t)args->getData(1), &sector) == true)
+    {
+      cliPrintf("%s sector %d : 0x%X, %dKB\n",
+                sector.type == FLASH_TYPE_CODE ? "code":"data",
+                sector.index,
+                sector.addr,
+                sector.length/1024);
+    }
+    else
+    {
+      cliPrintf("not in flash\n");
+    }
     ret = true;
   }
 
@@ -224,11 +278,7 @@ void cliFlash(cli_args_t *args)
     addr   = (uint32_t)args->getData(1);
     length = (uint32_t)args->getData(2);
 
-    for (int i=0; i<length; i++)
-    {
-      cliPrintf("0x%X : 0x%X\n", addr+i, *((uint8_t *)(addr+i)));
-    }
-
+    cliJobStart(cliFlashReadJob, addr, length);
     ret = true;
   }
 
@@ -248,6 +298,8 @@ void cliFlash(cli_args_t *args)
     {
       cliPrintf("Erase Fail\n");
     }
+
+    ret = true;
   }
 
   if (args->argc == 3 && args->isStr(0, "write") == true)
@@ -272,12 +324,70 @@ void cliFlash(cli_args_t *args)
 
   if (ret != true)
   {
-    cliPrintf("flash info\n");
+    cliPrintf("flash info [addr]\n");
     cliPrintf("flash read  addr length\n");
     cliPrintf("flash erase addr length\n");
     cliPrintf("flash write addr data\n");
   }
 }
+
+// 출력이 길어서 cliMain() 에서 FLASH_CLI_JOB_LINE 줄씩 나눠서 출력
+//
+bool cliFlashInfoJob(cli_job_t *p_job)
+{
+  uint32_t index;
+  const flash_tbl_t *p_tbl;
+
+  for (int i=0; i<FLASH_CLI_JOB_LINE && p_job->index < p_job->count; i++)
+  {
+    // index 를 영역 안의 섹터 번호로 바꾼다.
+    //
+    index = p_job->index;
+    p_tbl = &flash_tbl[0];
+    while(index >= p_tbl->sector_max)
+    {
+      index -= p_tbl->sector_max;
+      p_tbl++;
+    }
+
+    cliPrintf("0x%X : %dKB\n", p_tbl->addr + (index << p_tbl->sector_shift), (1 << p_tbl->sector_shift)/1024);
+    p_job->index++;
+  }
+
+  return p_job->index < p_job->count ? true:false;
+}
+
+bool cliFlashReadJob(cli_job_t *p_job)
+{
+  uint32_t addr;
+  uint32_t length;
+  char     line_str[64];
+  char    *p_str;
+
+  for (int i=0; i<FLASH_CLI_READ_LINE && p_job->index < p_job->count; i++)
+  {
+    addr   = p_job->addr + p_job->index;
+    length = min(16, p_job->count - p_job->index);
+
+    p_str = line_str;
+    *p_str++ = '0';
+    *p_str++ = 'x';
+    p_str = cliHexStr(p_str, addr, 8);
+    *p_str++ = ' ';
+    *p_str++ = ':';
+    for (int j=0; j<length; j++)
+    {
+      *p_str++ = ' ';
+      p_str = cliHexStr(p_str, *((uint8_t *)(addr + j)), 2);
+    }
+    *p_str++ = '\n';
+    cliWrite((uint8_t *)line_str, p_str - line_str);
+
+    p_job->index += length;
+  }
+
+  return p_job->index < p_job->count ? true:false;
+}
 #endif
 
 #endif
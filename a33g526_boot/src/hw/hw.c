@@ -19,6 +19,7 @@ __attribute__((section(".version"))) firm_version_t boot_ver =
 bool hwInit(void)
 {
   bspInit();
+  crcInit();
 
   logInit();
   ledInit();
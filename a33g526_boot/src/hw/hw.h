@@ -18,6 +18,9 @@
 #include "flash.h"
 #include "cmd.h"
 #include "util.h"
+#include "lz.h"
+#include "delta.h"
+#include "crc.h"
 
 
 bool hwInit(void);
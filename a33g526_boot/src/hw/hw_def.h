@@ -22,6 +22,7 @@
 
 #define _USE_HW_UART
 #define      HW_UART_MAX_CH         1
+#define      HW_UART_RX_BUF_LENGTH  4096      // Window 모드로 먼저 보낸 SEQ 패킷을 받아둘 수 있도록 (2의 거듭제곱)
 
 #define _USE_HW_LOG
 #define      HW_LOG_CH              _DEF_UART1
@@ -35,6 +36,7 @@
 
 
 
+#define FLASH_ADDR_BOOT_INFO        0x0007C00     // 부트로더 영역의 마지막 섹터, 펌웨어 확인 기록
 #define FLASH_ADDR_TAG              0x0008000
 #define FLASH_ADDR_FW               0x0008400
 #define FLASH_ADDR_FW_VER           0x0008800
@@ -42,5 +44,8 @@
 #define FLASH_ADDR_START            0x0008000
 #define FLASH_ADDR_END              (FLASH_ADDR_START + (256-32)*1024)
 
+#define RAM_ADDR_START              0x20000000
+#define RAM_ADDR_END                (RAM_ADDR_START + 24*1024)  // NOINIT 영역 포함
+
 
 #endif /* SRC_HW_HW_DEF_H_ */
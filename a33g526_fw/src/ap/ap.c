@@ -35,5 +35,6 @@ void apMain(void)
     }
 
     cliMain();
+    logMain();
   }
 }
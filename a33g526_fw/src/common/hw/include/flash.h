@@ -14,10 +14,24 @@
 #ifdef _USE_HW_FLASH
 
 
+#define FLASH_TYPE_CODE       0
+#define FLASH_TYPE_DATA       1
+
+
+typedef struct
+{
+  uint32_t addr;        // 섹터 시작 주소
+  uint32_t length;
+  uint16_t index;       // 영역(Code/Data) 안에서의 섹터 번호
+  uint8_t  type;
+} flash_sector_t;
+
+
 bool flashInit(void);
 bool flashErase(uint32_t addr, uint32_t length);
 bool flashWrite(uint32_t addr, uint8_t *p_data, uint32_t length);
 bool flashRead(uint32_t addr, uint8_t *p_data, uint32_t length);
+bool flashGetSectorInfo(uint32_t addr, flash_sector_t *p_info);
 
 
 #endif
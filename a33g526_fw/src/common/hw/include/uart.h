@@ -18,6 +18,24 @@ extern "C" {
 #ifdef _USE_HW_UART
 
 #define UART_MAX_CH         HW_UART_MAX_CH
+#define UART_BAUD_ERR_MAX   200     // 0.01% 단위, 이보다 오차가 크면 사용하지 않음
+#ifdef HW_UART_RX_BUF_LENGTH
+#define UART_RX_BUF_LENGTH  HW_UART_RX_BUF_LENGTH
+#else
+#define UART_RX_BUF_LENGTH  1024    // 채널당 수신 버퍼 크기, 한번에 받아둘 수 있는 최대 바이트 수
+#endif
+
+
+typedef struct
+{
+  uint32_t rx_cnt;
+  uint32_t tx_cnt;
+  uint32_t rx_drop_cnt;     // 수신 버퍼가 가득 차서 버린 바이트 수
+  uint32_t overrun_cnt;
+  uint32_t parity_err_cnt;
+  uint32_t frame_err_cnt;
+  uint32_t rx_peak;         // 수신 버퍼에 가장 많이 쌓였던 바이트 수
+} uart_stat_t;
 
 
 bool     uartInit(void);
@@ -26,9 +44,18 @@ bool     uartClose(uint8_t ch);
 uint32_t uartAvailable(uint8_t ch);
 bool     uartFlush(uint8_t ch);
 uint8_t  uartRead(uint8_t ch);
+uint32_t uartReadBytes(uint8_t ch, uint8_t *p_data, uint32_t length);
+uint32_t uartGetReadSpan(uint8_t ch, uint8_t **pp_data);
+void     uartConsume(uint8_t ch, uint32_t length);
 uint32_t uartWrite(uint8_t ch, uint8_t *p_data, uint32_t length);
+uint32_t uartTxAvailable(uint8_t ch);
+bool     uartFlushTx(uint8_t ch);
 uint32_t uartPrintf(uint8_t ch, const char *fmt, ...);
 uint32_t uartGetBaud(uint8_t ch);
+bool     uartSetBaud(uint8_t ch, uint32_t baud);
+uint32_t uartGetBaudError(uint8_t ch, uint32_t baud);
+bool     uartGetStat(uint8_t ch, uart_stat_t *p_stat);
+void     uartClearStat(uint8_t ch);
 
 #endif
 
@@ -31,6 +31,8 @@ button_tbl_t button_tbl[BUTTON_MAX_CH] =
 
 #ifdef _USE_HW_CLI
 static void cliButton(cli_args_t *args);
+
+CLI_CMD_ADD(button, cliButton);
 #endif
 
 
@@ -49,10 +51,6 @@ bool buttonInit(void)
     PCU_ConfigurePullupdown(button_tbl[i].pcu, button_tbl[i].pin, PUPD_DISABLE);
   }
 
-#ifdef _USE_HW_CLI
-  cliAdd("button", cliButton);
-#endif
-
   return ret;
 }
 
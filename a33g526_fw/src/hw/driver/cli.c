@@ -23,11 +23,17 @@
 #define CLI_KEY_DOWN              0x42
 #define CLI_KEY_HOME              0x31
 #define CLI_KEY_END               0x34
+#define CLI_KEY_CTRL_C            0x03
 
 #define CLI_PROMPT_STR            "cli# "
 
 #define CLI_ARGS_MAX              32
 #define CLI_PRINT_BUF_MAX         256
+#define CLI_RX_BUF_MAX            32
+#define CLI_BAUD_CONFIRM_TIME     5000      // ms, 새 속도에서 엔터가 없으면 이전 속도로 복귀
+#define CLI_MD_JOB_LINE           2         // md 작업 한번에 출력하는 줄 수 (줄당 약 80바이트)
+#define CLI_MD_LINE_MAX           96
+#define CLI_BATCH_SCRIPT_MAX      4096      // flash 스크립트 최대 길이, 0x00 또는 0xFF 에서 끝
 
 
 enum
@@ -40,13 +46,6 @@ enum
 };
 
 
-typedef struct
-{
-  char   cmd_str[CLI_CMD_NAME_MAX];
-  void (*cmd_func)(cli_args_t *);
-} cli_cmd_t;
-
-
 typedef struct
 {
   uint8_t buf[CLI_LINE_BUF_MAX];
@@ -69,6 +68,9 @@ typedef struct
   uint16_t  argc;
   char     *argv[CLI_ARGS_MAX];
 
+  uint8_t   rx_buf[CLI_RX_BUF_MAX];
+  uint8_t   rx_len;
+  uint8_t   rx_index;
 
   bool        hist_line_new;
   int8_t      hist_line_i;
@@ -79,8 +81,20 @@ typedef struct
   cli_line_t  line;
 
   uint16_t    cmd_count;
-  cli_cmd_t   cmd_list[CLI_CMD_LIST_MAX];
+  bool        cmd_is_sorted;
+  const cli_cmd_t *cmd_list;
   cli_args_t  cmd_args;
+
+  bool      (*job_func)(cli_job_t *p_job);
+  cli_job_t   job;
+
+  bool        is_batch;
+  bool        is_script;
+  bool        batch_is_long;
+  bool        batch_is_prev;      // 스크립트 시작 전의 is_batch, 끝나면 복구
+  uint16_t    batch_seq;
+  uint32_t    script_addr;
+  uint32_t    script_end;
 } cli_t;
 
 
@@ -90,13 +104,22 @@ cli_t   cli_node;
 
 
 static bool cliUpdate(cli_t *p_cli, uint8_t rx_data);
+static uint32_t cliRxAvailable(cli_t *p_cli);
+static uint8_t  cliRxRead(cli_t *p_cli);
 static void cliLineClean(cli_t *p_cli);
 static void cliLineAdd(cli_t *p_cli);
 static void cliLineChange(cli_t *p_cli, int8_t key_up);
 static void cliShowPrompt(cli_t *p_cli);
-static void cliToUpper(char *str);
+static void cliToLower(char *str);
 static bool cliRunCmd(cli_t *p_cli);
+static const cli_cmd_t *cliFindCmd(cli_t *p_cli, const char *cmd_str);
 static bool cliParseArgs(cli_t *p_cli);
+static void cliJobUpdate(cli_t *p_cli);
+static bool cliIsRunning(cli_t *p_cli);
+static void cliBatchUpdate(cli_t *p_cli, uint8_t rx_data);
+static void cliBatchRun(cli_t *p_cli);
+static void cliBatchScript(cli_t *p_cli);
+static bool cliMemoryDumpJob(cli_job_t *p_job);
 
 static int32_t  cliArgsGetData(uint8_t index);
 static float    cliArgsGetFloat(uint8_t index);
@@ -106,13 +129,29 @@ static bool     cliArgsIsStr(uint8_t index, char *p_str);
 
 void cliShowList(cli_args_t *args);
 void cliMemoryDump(cli_args_t *args);
+void cliBaud(cli_args_t *args);
+void cliBatch(cli_args_t *args);
+
+
+CLI_CMD_ADD(help,  cliShowList);
+CLI_CMD_ADD(md,    cliMemoryDump);
+CLI_CMD_ADD(baud,  cliBaud);
+CLI_CMD_ADD(batch, cliBatch);
+
+extern const cli_cmd_t __start_cli_cmd[];
+extern const cli_cmd_t __stop_cli_cmd[];
 
 
 bool cliInit(void)
 {
-  cli_node.is_open = false;
-  cli_node.is_log  = false;
-  cli_node.state   = CLI_RX_IDLE;
+  cli_node.is_open  = false;
+  cli_node.is_log   = false;
+  cli_node.state    = CLI_RX_IDLE;
+  cli_node.rx_len   = 0;
+  cli_node.rx_index = 0;
+  cli_node.job_func = NULL;
+  cli_node.is_batch  = false;
+  cli_node.is_script = false;
 
   cli_node.hist_line_i     = 0;
   cli_node.hist_line_last  = 0;
@@ -127,8 +166,19 @@ bool cliInit(void)
   cliLineClean(&cli_node);
 
 
-  cliAdd("help", cliShowList);
-  cliAdd("md"  , cliMemoryDump);
+  // 링커에서 정렬되지 않았으면 순서대로 찾는다.
+  //
+  cli_node.cmd_list      = __start_cli_cmd;
+  cli_node.cmd_count     = __stop_cli_cmd - __start_cli_cmd;
+  cli_node.cmd_is_sorted = true;
+  for (int i=1; i<cli_node.cmd_count; i++)
+  {
+    if (strcmp(cli_node.cmd_list[i-1].cmd_str, cli_node.cmd_list[i].cmd_str) >= 0)
+    {
+      cli_node.cmd_is_sorted = false;
+      break;
+    }
+  }
 
   return true;
 }
@@ -198,22 +248,247 @@ bool cliMain(void)
     return false;
   }
 
-  if (uartAvailable(cli_node.ch) > 0)
+  // 긴 출력 작업 중이면 TX 버퍼가 비는 만큼만 이어서 출력하고 바로 리턴
+  //
+  if (cli_node.job_func != NULL)
   {
-    cliUpdate(&cli_node, uartRead(cli_node.ch));
+    cliJobUpdate(&cli_node);
+    return true;
+  }
+
+  // flash 스크립트는 cliMain() 한번에 한줄씩 실행
+  //
+  if (cli_node.is_script == true)
+  {
+    cliBatchScript(&cli_node);
+    return true;
+  }
+
+  // 받은 데이터를 한번에 읽어서 처리
+  // 명령어 안에서 입력을 읽으면 남은 데이터부터 읽도록 cli_node 에 보관한다.
+  //
+  if (cli_node.rx_index >= cli_node.rx_len)
+  {
+    cli_node.rx_index = 0;
+    cli_node.rx_len   = (uint8_t)uartReadBytes(cli_node.ch, cli_node.rx_buf, CLI_RX_BUF_MAX);
+  }
+
+  while(cli_node.rx_index < cli_node.rx_len && cliIsRunning(&cli_node) != true)
+  {
+    if (cli_node.is_batch == true)
+    {
+      cliBatchUpdate(&cli_node, cli_node.rx_buf[cli_node.rx_index++]);
+    }
+    else
+    {
+      cliUpdate(&cli_node, cli_node.rx_buf[cli_node.rx_index++]);
+    }
   }
 
   return true;
 }
 
+bool cliJobStart(bool (*p_func)(cli_job_t *p_job), uint32_t addr, uint32_t count)
+{
+  if (cli_node.job_func != NULL || p_func == NULL)
+  {
+    return false;
+  }
+
+  cli_node.job.addr  = addr;
+  cli_node.job.index = 0;
+  cli_node.job.count = count;
+  cli_node.job_func  = p_func;
+
+  return true;
+}
+
+bool cliJobIsBusy(void)
+{
+  return cli_node.job_func != NULL ? true:false;
+}
+
+void cliJobUpdate(cli_t *p_cli)
+{
+  bool is_done = false;
+
+
+  // 배치 모드는 다음 명령이 이어서 들어오므로 입력을 남겨둔다.
+  //
+  while(p_cli->is_batch != true && cliRxAvailable(p_cli) > 0)
+  {
+    if (cliRxRead(p_cli) == CLI_KEY_CTRL_C)
+    {
+      cliPrintf("\n^C");
+      is_done = true;
+      break;
+    }
+  }
+
+  // p_func 출력이 TX 버퍼에 모두 들어가므로 uartWrite() 에서 기다리지 않는다.
+  //
+  if (is_done != true && uartTxAvailable(p_cli->ch) >= CLI_JOB_TX_MIN)
+  {
+    if (p_cli->job_func(&p_cli->job) != true)
+    {
+      is_done = true;
+    }
+  }
+
+  if (is_done == true)
+  {
+    p_cli->job_func = NULL;
+
+    if (p_cli->is_batch == true)
+    {
+      cliPrintf("#%d OK\n", p_cli->batch_seq);
+    }
+    else
+    {
+      cliShowPrompt(p_cli);
+    }
+  }
+}
+
+bool cliIsRunning(cli_t *p_cli)
+{
+  return (p_cli->job_func != NULL || p_cli->is_script == true) ? true:false;
+}
+
+// 배치 모드 : 에코, 줄 편집, 히스토리, 프롬프트 없이 줄 단위로 실행하고
+// 명령마다 "#번호 OK" 또는 "#번호 ERR 이유" 한줄로 결과를 알린다.
+//
+void cliBatchUpdate(cli_t *p_cli, uint8_t rx_data)
+{
+  cli_line_t *line;
+
+  line = &p_cli->line;
+
+
+  if (rx_data == '\r' || rx_data == '\n')
+  {
+    if (line->count > 0 || p_cli->batch_is_long == true)
+    {
+      cliBatchRun(p_cli);
+    }
+  }
+  else if (line->count < line->buf_len)
+  {
+    line->buf[line->count++] = rx_data;
+  }
+  else
+  {
+    p_cli->batch_is_long = true;
+  }
+}
+
+void cliBatchRun(cli_t *p_cli)
+{
+  cli_line_t *line;
+
+  line = &p_cli->line;
+
+
+  p_cli->batch_seq++;
+  line->buf[line->count] = 0;
+
+  if (p_cli->batch_is_long == true)
+  {
+    cliPrintf("#%d ERR LONG\n", p_cli->batch_seq);
+  }
+  else if (strcmp((char *)line->buf, "exit") == 0)
+  {
+    // 스크립트 중이면 스크립트도 중단하고 대화 모드로 돌아간다.
+    //
+    p_cli->is_batch      = false;
+    p_cli->batch_is_prev = false;
+    p_cli->script_end    = p_cli->script_addr;
+    cliPrintf("#%d OK\n", p_cli->batch_seq);
+
+    if (p_cli->is_script != true)
+    {
+      cliShowPrompt(p_cli);
+    }
+  }
+  else if (cliRunCmd(p_cli) != true)
+  {
+    cliPrintf("#%d ERR NOCMD\n", p_cli->batch_seq);
+  }
+  else if (p_cli->job_func == NULL)
+  {
+    cliPrintf("#%d OK\n", p_cli->batch_seq);
+  }
+
+  line->count   = 0;
+  line->cursor  = 0;
+  line->buf[0]  = 0;
+  p_cli->batch_is_long = false;
+}
+
+void cliBatchScript(cli_t *p_cli)
+{
+  uint16_t seq;
+  uint8_t  data;
+
+
+  // 마지막 줄에 줄바꿈이 없으면 실행하고, 다음에 종료
+  //
+  if (p_cli->script_addr >= p_cli->script_end)
+  {
+    if (p_cli->line.count > 0 || p_cli->batch_is_long == true)
+    {
+      cliBatchRun(p_cli);
+      return;
+    }
+
+    p_cli->is_script = false;
+    p_cli->is_batch  = p_cli->batch_is_prev;
+    cliPrintf("#END %d\n", p_cli->batch_seq);
+
+    if (p_cli->is_batch != true)
+    {
+      cliShowPrompt(p_cli);
+    }
+    return;
+  }
+
+  seq = p_cli->batch_seq;
+  while(p_cli->script_addr < p_cli->script_end && seq == p_cli->batch_seq)
+  {
+    data = *((uint8_t *)p_cli->script_addr);
+    if (data == 0x00 || data == 0xFF)
+    {
+      p_cli->script_end = p_cli->script_addr;
+      break;
+    }
+    p_cli->script_addr++;
+
+    cliBatchUpdate(p_cli, data);
+  }
+}
+
 uint32_t cliAvailable(void)
 {
-  return uartAvailable(cli_node.ch);
+  return cliRxAvailable(&cli_node);
 }
 
 uint8_t cliRead(void)
 {
-  return uartRead(cli_node.ch);
+  return cliRxRead(&cli_node);
+}
+
+uint32_t cliRxAvailable(cli_t *p_cli)
+{
+  return (p_cli->rx_len - p_cli->rx_index) + uartAvailable(p_cli->ch);
+}
+
+uint8_t cliRxRead(cli_t *p_cli)
+{
+  if (p_cli->rx_index < p_cli->rx_len)
+  {
+    return p_cli->rx_buf[p_cli->rx_index++];
+  }
+  return uartRead(p_cli->ch);
 }
 
 uint32_t cliWrite(uint8_t *p_data, uint32_t length)
@@ -221,6 +496,21 @@ uint32_t cliWrite(uint8_t *p_data, uint32_t length)
   return uartWrite(cli_node.ch, p_data, length);
 }
 
+// data 의 하위 digits 자리를 16진수 대문자로 쓰고 다음 위치를 리턴 (0 으로 끝내지 않음)
+//
+char *cliHexStr(char *p_str, uint32_t data, uint8_t digits)
+{
+  const char hex_tbl[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+  for (int i=digits-1; i>=0; i--)
+  {
+    p_str[i] = hex_tbl[data & 0x0F];
+    data >>= 4;
+  }
+
+  return &p_str[digits];
+}
+
 bool cliUpdate(cli_t *p_cli, uint8_t rx_data)
 {
   bool ret = false;
@@ -246,7 +536,13 @@ bool cliUpdate(cli_t *p_cli, uint8_t rx_data)
         line->count = 0;
         line->cursor = 0;
         line->buf[0] = 0;
-        cliShowPrompt(p_cli);
+
+        // 작업이 등록되었으면 프롬프트는 작업이 끝난 후 출력
+        //
+        if (cliIsRunning(p_cli) != true && p_cli->is_batch != true)
+        {
+          cliShowPrompt(p_cli);
+        }
         break;
 
 
@@ -501,27 +797,73 @@ void cliLineChange(cli_t *p_cli, int8_t key_up)
 bool cliRunCmd(cli_t *p_cli)
 {
   bool ret = false;
+  const cli_cmd_t *p_cmd;
 
 
   if (cliParseArgs(p_cli) == true)
   {
-    cliPrintf("\r\n");
+    if (p_cli->is_batch != true)
+    {
+      cliPrintf("\r\n");
+    }
+
+    cliToLower(p_cli->argv[0]);
+
+    p_cmd = cliFindCmd(p_cli, p_cli->argv[0]);
+    if (p_cmd != NULL)
+    {
+      p_cli->cmd_args.argc =  p_cli->argc - 1;
+      p_cli->cmd_args.argv = &p_cli->argv[1];
+      p_cmd->cmd_func(&p_cli->cmd_args);
+      ret = true;
+    }
+  }
 
-    cliToUpper(p_cli->argv[0]);
+  return ret;
+}
+
+const cli_cmd_t *cliFindCmd(cli_t *p_cli, const char *cmd_str)
+{
+  int32_t low;
+  int32_t high;
+  int32_t mid;
+  int     cmp;
 
+
+  if (p_cli->cmd_is_sorted != true)
+  {
     for (int i=0; i<p_cli->cmd_count; i++)
     {
-      if (strcmp(p_cli->argv[0], p_cli->cmd_list[i].cmd_str) == 0)
+      if (strcmp(cmd_str, p_cli->cmd_list[i].cmd_str) == 0)
       {
-        p_cli->cmd_args.argc =  p_cli->argc - 1;
-        p_cli->cmd_args.argv = &p_cli->argv[1];
-        p_cli->cmd_list[i].cmd_func(&p_cli->cmd_args);
-        break;
+        return &p_cli->cmd_list[i];
       }
     }
+    return NULL;
   }
 
-  return ret;
+  low  = 0;
+  high = p_cli->cmd_count - 1;
+  while(low <= high)
+  {
+    mid = (low + high) / 2;
+    cmp = strcmp(cmd_str, p_cli->cmd_list[mid].cmd_str);
+    if (cmp == 0)
+    {
+      return &p_cli->cmd_list[mid];
+    }
+
+    if (cmp < 0)
+    {
+      high = mid - 1;
+    }
+    else
+    {
+      low = mid + 1;
+    }
+  }
+
+  return NULL;
 }
 
 bool cliParseArgs(cli_t *p_cli)
@@ -570,7 +912,7 @@ void cliPrintf(const char *fmt, ...)
   uartWrite(p_cli->ch, (uint8_t *)p_cli->print_buffer, len);
 }
 
-void cliToUpper(char *str)
+void cliToLower(char *str)
 {
   uint16_t i;
   uint8_t  str_ch;
@@ -584,9 +926,9 @@ void cliToUpper(char *str)
       break;
     }
 
-    if ((str_ch >= 'a') && (str_ch <= 'z'))
+    if ((str_ch >= 'A') && (str_ch <= 'Z'))
     {
-      str_ch = str_ch - 'a' + 'A';
+      str_ch = str_ch - 'A' + 'a';
     }
     str[i] = str_ch;
   }
@@ -669,7 +1011,7 @@ bool cliKeepLoop(void)
   cli_t *p_cli = &cli_node;
 
 
-  if (uartAvailable(p_cli->ch) == 0)
+  if (cliRxAvailable(p_cli) == 0)
   {
     return true;
   }
@@ -679,53 +1021,126 @@ bool cliKeepLoop(void)
   }
 }
 
-bool cliAdd(const char *cmd_str, void (*p_func)(cli_args_t *))
+void cliShowList(cli_args_t *args)
 {
-  bool ret = true;
   cli_t *p_cli = &cli_node;
-  uint16_t index;
 
-  if (p_cli->cmd_count >= CLI_CMD_LIST_MAX)
+
+  cliPrintf("\r\n");
+  cliPrintf("---------- cmd list ---------\r\n");
+
+  for (int i=0; i<p_cli->cmd_count; i++)
   {
-    return false;
+    cliPrintf(p_cli->cmd_list[i].cmd_str);
+    cliPrintf("\r\n");
+  }
+
+  cliPrintf("-----------------------------\r\n");
+}
+
+void cliBaud(cli_args_t *args)
+{
+  cli_t *p_cli = &cli_node;
+  uint32_t baud;
+  uint32_t baud_old;
+  uint32_t pre_time;
+  bool is_ok = false;
+
+
+  if (args->argc != 1)
+  {
+    cliPrintf("baud : %d\r\n", p_cli->baud);
+    cliPrintf("baud 921600\r\n");
+    return;
   }
 
-  index = p_cli->cmd_count;
+  baud     = (uint32_t)args->getData(0);
+  baud_old = p_cli->baud;
 
-  strcpy(p_cli->cmd_list[index].cmd_str, cmd_str);
-  p_cli->cmd_list[index].cmd_func = p_func;
+  if (uartGetBaudError(p_cli->ch, baud) > UART_BAUD_ERR_MAX)
+  {
+    cliPrintf("baud %d not supported\r\n", baud);
+    return;
+  }
 
-  cliToUpper(p_cli->cmd_list[index].cmd_str);
+  cliPrintf("change to %d, press enter in %d ms\r\n", baud, CLI_BAUD_CONFIRM_TIME);
 
-  p_cli->cmd_count++;
+  // 새 속도에서 엔터를 받으면 변경 완료, 아니면 이전 속도로 복귀.
+  //
+  uartSetBaud(p_cli->ch, baud);
+  uartFlush(p_cli->ch);
+  p_cli->rx_index = p_cli->rx_len;
 
-  return ret;
+  pre_time = millis();
+  while(millis()-pre_time < CLI_BAUD_CONFIRM_TIME)
+  {
+    if (cliRxAvailable(p_cli) > 0 && cliRxRead(p_cli) == CLI_KEY_ENTER)
+    {
+      is_ok = true;
+      break;
+    }
+  }
+
+  if (is_ok == true)
+  {
+    p_cli->baud = baud;
+    cliPrintf("baud : %d OK\r\n", baud);
+  }
+  else
+  {
+    uartSetBaud(p_cli->ch, baud_old);
+    cliPrintf("baud : %d fail, back to %d\r\n", baud, baud_old);
+  }
 }
 
-void cliShowList(cli_args_t *args)
+void cliBatch(cli_args_t *args)
 {
   cli_t *p_cli = &cli_node;
+  bool ret = false;
 
 
-  cliPrintf("\r\n");
-  cliPrintf("---------- cmd list ---------\r\n");
+  if (args->argc == 0)
+  {
+    p_cli->is_batch      = true;
+    p_cli->batch_is_long = false;
+    p_cli->batch_seq     = 0;
+    cliPrintf("#BATCH\n");
+    ret = true;
+  }
 
-  for (int i=0; i<p_cli->cmd_count; i++)
+  if (args->argc == 2 && args->isStr(0, "run") == true)
   {
-    cliPrintf(p_cli->cmd_list[i].cmd_str);
-    cliPrintf("\r\n");
+    if (p_cli->is_script == true)
+    {
+      cliPrintf("script running\n");
+    }
+    else
+    {
+      p_cli->batch_is_prev = p_cli->is_batch;
+      if (p_cli->is_batch != true)
+      {
+        p_cli->batch_seq = 0;
+      }
+      p_cli->is_batch      = true;
+      p_cli->is_script     = true;
+      p_cli->batch_is_long = false;
+      p_cli->script_addr   = (uint32_t)args->getData(1);
+      p_cli->script_end    = p_cli->script_addr + CLI_BATCH_SCRIPT_MAX;
+    }
+    ret = true;
   }
 
-  cliPrintf("-----------------------------\r\n");
+  if (ret != true)
+  {
+    cliPrintf("batch          : no echo, \"#n OK\" per line, \"exit\" to quit\n");
+    cliPrintf("batch run addr : run script in flash (ends at 0x00 or 0xFF)\n");
+  }
 }
 
 void cliMemoryDump(cli_args_t *args)
 {
-  int idx, size = 16;
-  unsigned int *addr;
-  int idx1, i;
-  unsigned int *ascptr;
-  unsigned char asc[4];
+  uint32_t addr;
+  uint32_t size = 16;
 
   int    argc = args->argc;
   char **argv = args->argv;
@@ -739,43 +1154,67 @@ void cliMemoryDump(cli_args_t *args)
 
   if(argc > 1)
   {
-    size = (int)strtoul((const char * ) argv[1], (char **)NULL, (int) 0);
+    size = (uint32_t)strtoul((const char * ) argv[1], (char **)NULL, (int) 0);
   }
-  addr   = (unsigned int *)strtoul((const char * ) argv[0], (char **)NULL, (int) 0);
-  ascptr = (unsigned int *)addr;
+  addr = (uint32_t)strtoul((const char * ) argv[0], (char **)NULL, (int) 0);
+
+  cliJobStart(cliMemoryDumpJob, addr, size);
+}
+
+// 한번에 CLI_MD_JOB_LINE 줄(4워드씩)만 출력
+// 값마다 vsnprintf 를 거치지 않도록 한 줄을 cliHexStr() 로 만들어서 한번에 보낸다.
+//
+bool cliMemoryDumpJob(cli_job_t *p_job)
+{
+  uint32_t *addr;
+  uint8_t  *asc;
+  uint32_t  words;
+  char      line_str[CLI_MD_LINE_MAX];
+  char     *p_str;
+
 
-  cliPrintf("\n   ");
-  for (idx = 0; idx<size; idx++)
+  for (int line=0; line<CLI_MD_JOB_LINE && p_job->index < p_job->count; line++)
   {
-    if((idx%4) == 0)
+    addr  = (uint32_t *)(p_job->addr + p_job->index*4);
+    words = min(4, p_job->count - p_job->index);
+
+    p_str = line_str;
+    for (int i=0; i<4; i++)
+    {
+      *p_str++ = ' ';
+    }
+    *p_str++ = '0';
+    *p_str++ = 'x';
+    p_str = cliHexStr(p_str, (uint32_t)addr, 8);
+    *p_str++ = ':';
+    *p_str++ = ' ';
+    for (int i=0; i<words; i++)
     {
-      cliPrintf(" 0x%08X: ", (unsigned int)addr);
+      *p_str++ = ' ';
+      *p_str++ = '0';
+      *p_str++ = 'x';
+      p_str = cliHexStr(p_str, addr[i], 8);
     }
-    cliPrintf(" 0x%08X", *(addr));
 
-    if ((idx%4) == 3)
+    if (words == 4)
     {
-      cliPrintf ("  |");
-      for (idx1= 0; idx1< 4; idx1++)
+      asc = (uint8_t *)addr;
+      *p_str++ = ' ';
+      *p_str++ = ' ';
+      *p_str++ = '|';
+      for (int i=0; i<16; i++)
       {
-        memcpy((char *)asc, (char *)ascptr, 4);
-        for (i=0;i<4;i++)
-        {
-          if (asc[i] > 0x1f && asc[i] < 0x7f)
-          {
-            cliPrintf("%c", asc[i]);
-          }
-          else
-          {
-            cliPrintf(".");
-          }
-        }
-        ascptr+=1;
+        *p_str++ = (asc[i] > 0x1f && asc[i] < 0x7f) ? asc[i]:'.';
       }
-      cliPrintf("|\n   ");
+      *p_str++ = '|';
     }
-    addr++;
+    *p_str++ = '\n';
+    cliWrite((uint8_t *)line_str, p_str - line_str);
+
+    p_job->index += words;
   }
+
+  return p_job->index < p_job->count ? true:false;
 }
 
 #endif
@@ -8,13 +8,59 @@
 
 #include "log.h"
 #include "uart.h"
+#include "cli.h"
+#include "reset.h"
 
 
 #ifdef _USE_HW_LOG
 
 
+#ifdef _USE_HW_LOG_DEFER
+
+#define LOG_DEFER_HEADER        0x5A000000    // 헤더 워드가 0 이 아니면 쓰기가 끝난 레코드
+#define LOG_DEFER_FRAME_STX     0xA5          // 바이너리 출력 : STX, argc, ID(16), 인자(32 x argc)
+#define LOG_DEFER_TX_MIN        256           // 송신 버퍼에 이만큼 비어 있을 때만 꺼내서 보냄
+
+
+typedef struct
+{
+  uint32_t in;
+  uint32_t out;
+  uint32_t drop_cnt;
+  uint32_t drop_report;
+  bool     is_binary;
+  uint32_t buf[LOG_DEFER_BUF_MAX];
+} log_defer_t;
+
+static void logDeferSend(uint32_t header, uint32_t *p_args);
+
+static log_defer_t log_defer;
+
+extern const char __start_log_str[];
+#endif
+
+
 static uint8_t log_ch = LOG_CH;
 static char print_buf[256];
+static uint8_t  log_level = LOG_LEVEL;
+static uint32_t log_mod_mask = (1<<LOG_MOD_MAX) - 1;
+
+#ifdef _USE_HW_CLI
+static const char *log_mod_name[LOG_MOD_MAX] =
+    {
+        "ap",
+        "hw",
+        "uart",
+        "flash",
+        "cli",
+        "boot",
+        "cmd",
+    };
+
+static void cliLog(cli_args_t *args);
+
+CLI_CMD_ADD(log, cliLog);
+#endif
 
 #ifdef _USE_HW_ROTS
 static osMutexId mutex_lock;
@@ -42,6 +88,10 @@ void logPrintf(const char *fmt, ...)
 
   va_start(args, fmt);
   len = vsnprintf(print_buf, 256, fmt, args);
+  len = min(len, 255);
+#ifdef _USE_HW_RESET
+  resetLogWrite((uint8_t *)print_buf, len);
+#endif
 
   uartWrite(log_ch, (uint8_t *)print_buf, len);
   va_end(args);
@@ -51,6 +101,259 @@ void logPrintf(const char *fmt, ...)
 #endif
 }
 
+// logError() ~ logTrace() 에서 호출, 레벨/모듈 필터와 같은 위치의 반복 로그 제한
+//
+bool logCheck(log_rate_t *p_rate, uint8_t level, uint8_t mod)
+{
+  uint32_t cur_time;
+
+
+  if (level > log_level || mod >= LOG_MOD_MAX || (log_mod_mask & (1<<mod)) == 0)
+  {
+    return false;
+  }
+
+  cur_time = millis();
+  if (cur_time - p_rate->pre_time >= LOG_RATE_TIME)
+  {
+    if (p_rate->skip_cnt > 0)
+    {
+      logDefer("[log] %d skipped\r\n", p_rate->skip_cnt);
+    }
+    p_rate->pre_time = cur_time;
+    p_rate->count    = 0;
+    p_rate->skip_cnt = 0;
+  }
+
+  if (p_rate->count >= LOG_RATE_MAX)
+  {
+    p_rate->skip_cnt++;
+    return false;
+  }
+  p_rate->count++;
+
+  return true;
+}
+
+void logSetLevel(uint8_t level)
+{
+  log_level = min(level, LOG_LEVEL);
+}
+
+void logSetModule(uint8_t mod, bool enable)
+{
+  if (mod >= LOG_MOD_MAX)
+  {
+    return;
+  }
+
+  if (enable == true)
+  {
+    log_mod_mask |= (1<<mod);
+  }
+  else
+  {
+    log_mod_mask &= ~(1<<mod);
+  }
+}
+
+// 메인 루프에서 호출, logDefer() 로 쌓인 로그를 출력
+//
+void logMain(void)
+{
+#ifdef _USE_HW_LOG_DEFER
+  uint32_t out;
+  uint32_t header;
+  uint32_t argc;
+  uint32_t args[LOG_DEFER_ARG_MAX] = {0, };
+  uint32_t drop_cnt;
+
+
+  drop_cnt = __atomic_load_n(&log_defer.drop_cnt, __ATOMIC_RELAXED);
+  if (drop_cnt != log_defer.drop_report && log_defer.is_binary != true)
+  {
+    logPrintf("[log] %d dropped\r\n", drop_cnt - log_defer.drop_report);
+    log_defer.drop_report = drop_cnt;
+  }
+
+  out = log_defer.out;
+  while(uartTxAvailable(log_ch) >= LOG_DEFER_TX_MIN)
+  {
+    header = __atomic_load_n(&log_defer.buf[out & (LOG_DEFER_BUF_MAX - 1)], __ATOMIC_ACQUIRE);
+    if (header == 0)
+    {
+      break;
+    }
+    argc = (header >> 16) & 0xFF;
+
+    // 다음에 헤더 자리로 쓰일 수 있으므로 읽은 워드는 0 으로 지운다.
+    //
+    log_defer.buf[out & (LOG_DEFER_BUF_MAX - 1)] = 0;
+    for (int i=0; i<argc; i++)
+    {
+      args[i] = log_defer.buf[(out + 1 + i) & (LOG_DEFER_BUF_MAX - 1)];
+      log_defer.buf[(out + 1 + i) & (LOG_DEFER_BUF_MAX - 1)] = 0;
+    }
+    out += 1 + argc;
+    __atomic_store_n(&log_defer.out, out, __ATOMIC_RELEASE);
+
+    logDeferSend(header, args);
+  }
+#endif
+}
+
+
+
+#ifdef _USE_HW_LOG_DEFER
+// 인터럽트와 메인 루프 어디서든 호출 가능 (lock-free, 버퍼가 가득 차면 버리고 drop_cnt 증가)
+//
+bool logDeferPush(const char *p_fmt, uint32_t argc, const uint32_t *p_args)
+{
+  uint32_t in;
+  uint32_t out;
+  uint32_t length;
+
+
+  argc   = min(argc, LOG_DEFER_ARG_MAX);
+  length = 1 + argc;
+
+  // 필요한 워드만큼 in 을 먼저 옮겨서 자리를 잡는다.
+  //
+  in = __atomic_load_n(&log_defer.in, __ATOMIC_RELAXED);
+  do
+  {
+    out = __atomic_load_n(&log_defer.out, __ATOMIC_ACQUIRE);
+    if (LOG_DEFER_BUF_MAX - (in - out) < length)
+    {
+      __atomic_fetch_add(&log_defer.drop_cnt, 1, __ATOMIC_RELAXED);
+      return false;
+    }
+  } while(__atomic_compare_exchange_n(&log_defer.in, &in, in + length, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) != true);
+
+  for (int i=0; i<argc; i++)
+  {
+    log_defer.buf[(in + 1 + i) & (LOG_DEFER_BUF_MAX - 1)] = p_args[i];
+  }
+
+  // 헤더를 마지막에 써서 logMain() 에서 다 써진 레코드만 읽도록
+  //
+  __atomic_store_n(&log_defer.buf[in & (LOG_DEFER_BUF_MAX - 1)],
+                   LOG_DEFER_HEADER | (argc << 16) | (uint16_t)(p_fmt - __start_log_str),
+                   __ATOMIC_RELEASE);
+
+  return true;
+}
+
+void logDeferBinary(bool enable)
+{
+  log_defer.is_binary = enable;
+}
+
+void logDeferSend(uint32_t header, uint32_t *p_args)
+{
+  uint32_t argc;
+  uint32_t id;
+  int len;
+
+  argc = (header >> 16) & 0xFF;
+  id   = header & 0xFFFF;
+
+  // 남는 인자는 무시되므로 항상 최대 개수로 넘긴다.
+  // 바이너리 출력이어도 리셋 로그에는 텍스트로 남긴다.
+  //
+  len = snprintf(print_buf, 256, &__start_log_str[id],
+                 p_args[0], p_args[1], p_args[2], p_args[3], p_args[4], p_args[5]);
+  len = min(len, 255);
+#ifdef _USE_HW_RESET
+  resetLogWrite((uint8_t *)print_buf, len);
+#endif
+
+  // 바이너리 : 포맷 문자열은 tools/logdecode 가 ELF 의 log_str 섹션에서 찾는다.
+  //
+  if (log_defer.is_binary == true)
+  {
+    uint8_t frame[4 + LOG_DEFER_ARG_MAX * 4];
+
+    frame[0] = LOG_DEFER_FRAME_STX;
+    frame[1] = argc;
+    frame[2] = (id >> 0) & 0xFF;
+    frame[3] = (id >> 8) & 0xFF;
+    for (int i=0; i<argc; i++)
+    {
+      frame[4 + i*4 + 0] = (p_args[i] >>  0) & 0xFF;
+      frame[4 + i*4 + 1] = (p_args[i] >>  8) & 0xFF;
+      frame[4 + i*4 + 2] = (p_args[i] >> 16) & 0xFF;
+      frame[4 + i*4 + 3] = (p_args[i] >> 24) & 0xFF;
+    }
+    uartWrite(log_ch, frame, 4 + argc * 4);
+    return;
+  }
+
+  uartWrite(log_ch, (uint8_t *)print_buf, len);
+}
+#endif
+
+
+
+#ifdef _USE_HW_CLI
+void cliLog(cli_args_t *args)
+{
+  bool ret = false;
+
+
+  if (args->argc == 1 && args->isStr(0, "info") == true)
+  {
+    cliPrintf("level : %d (build %d)\n", log_level, LOG_LEVEL);
+    for (int i=0; i<LOG_MOD_MAX; i++)
+    {
+      cliPrintf("  %-6s : %s\n", log_mod_name[i], (log_mod_mask & (1<<i)) ? "on":"off");
+    }
+    ret = true;
+  }
+
+  if (args->argc == 2 && args->isStr(0, "level") == true)
+  {
+    logSetLevel((uint8_t)args->getData(1));
+    cliPrintf("level : %d\n", log_level);
+    ret = true;
+  }
+
+  if (args->argc == 3 && args->isStr(0, "mod") == true)
+  {
+    bool enable;
+
+    enable = args->isStr(2, "on");
+    for (int i=0; i<LOG_MOD_MAX; i++)
+    {
+      if (args->isStr(1, "all") == true || args->isStr(1, (char *)log_mod_name[i]) == true)
+      {
+        logSetModule(i, enable);
+        ret = true;
+      }
+    }
+  }
+
+#ifdef _USE_HW_LOG_DEFER
+  if (args->argc == 2 && args->isStr(0, "bin") == true)
+  {
+    logDeferBinary(args->isStr(1, "on"));
+    ret = true;
+  }
+#endif
+
+
+  if (ret != true)
+  {
+    cliPrintf("log info\n");
+    cliPrintf("log level 0~%d\n", LOG_LEVEL);
+    cliPrintf("log mod all|name on|off\n");
+#ifdef _USE_HW_LOG_DEFER
+    cliPrintf("log bin on|off\n");
+#endif
+  }
+}
+#endif
+
 
 
 #endif
@@ -0,0 +1,253 @@
+/*
+ * reset.c
+ *
+ *  Created on: 2021. 8. 16.
+ *      Author: baram
+ */
+
+
+#include "reset.h"
+#include "cli.h"
+
+
+#ifdef _USE_HW_RESET
+
+
+#define RESET_MAGIC_NUMBER      0x52535432    // "RST2", reset_log_t 가 바뀌면 변경
+
+
+typedef struct
+{
+  uint32_t is_valid;
+  uint32_t count;                     // 이 Fault 로 생긴 리셋의 count
+  uint32_t r0;
+  uint32_t r1;
+  uint32_t r2;
+  uint32_t r3;
+  uint32_t r12;
+  uint32_t lr;
+  uint32_t pc;
+  uint32_t xpsr;
+  uint32_t cfsr;
+  uint32_t hfsr;
+  uint32_t mmfar;
+  uint32_t bfar;
+} reset_fault_t;
+
+typedef struct
+{
+  uint32_t magic_number;
+  uint32_t count;
+  uint32_t reason;                    // PMU RSSR, 0 이면 Power On Reset
+  reset_fault_t fault;
+
+  uint32_t log_in;                    // 계속 증가, log_buf 는 마지막 RESET_LOG_BUF_MAX 바이트
+  uint8_t  log_buf[RESET_LOG_BUF_MAX];
+} reset_log_t;
+
+
+void resetFaultHandler(uint32_t *p_stack);
+
+#ifdef _USE_HW_CLI
+static void cliReset(cli_args_t *args);
+
+CLI_CMD_ADD(reset, cliReset);
+#endif
+
+
+// 리셋 후에도 지워지지 않도록 .noinit (boot 와 fw 모두 RAM 영역에서 제외)
+//
+__attribute__((section(".noinit"))) static reset_log_t reset_log;
+
+static const char *reset_reason_str[8] =
+    {
+        "LVD",
+        "Main X-tal Fail",
+        "Sub X-tal Fail",
+        "Watchdog",
+        "Software",
+        "Core Request",
+        "nReset",
+        "Main Clock Fail",
+    };
+
+
+
+
+bool resetInit(void)
+{
+  // 전원이 처음 들어오면 RAM 값이 정해져 있지 않으므로 새로 만든다.
+  //
+  if (reset_log.magic_number != RESET_MAGIC_NUMBER || reset_log.log_in > 0x7FFFFFFF)
+  {
+    memset(&reset_log, 0, sizeof(reset_log));
+    reset_log.magic_number = RESET_MAGIC_NUMBER;
+  }
+
+  // PMU_CheckResetEvent() 는 cprintf 를 사용하므로 RSSR 을 직접 읽고 지운다.
+  //
+  reset_log.count++;
+  reset_log.reason = PMU->RSSR;
+  PMU->RSSR = 0;
+
+  return true;
+}
+
+uint32_t resetGetCount(void)
+{
+  return reset_log.count;
+}
+
+uint32_t resetGetReason(void)
+{
+  return reset_log.reason;
+}
+
+void resetToBoot(uint32_t timeout)
+{
+  delay(timeout);
+  NVIC_SystemReset();
+}
+
+void resetLogWrite(uint8_t *p_data, uint32_t length)
+{
+  uint32_t in;
+
+  in = reset_log.log_in;
+  for (int i=0; i<length; i++)
+  {
+    reset_log.log_buf[(in + i) % RESET_LOG_BUF_MAX] = p_data[i];
+  }
+  reset_log.log_in = in + length;
+}
+
+// HardFault_Handler() 에서 예외 발생 시 쌓인 스택 주소를 받아서 기록 후 리셋
+//
+void resetFaultHandler(uint32_t *p_stack)
+{
+  reset_log.fault.r0    = p_stack[0];
+  reset_log.fault.r1    = p_stack[1];
+  reset_log.fault.r2    = p_stack[2];
+  reset_log.fault.r3    = p_stack[3];
+  reset_log.fault.r12   = p_stack[4];
+  reset_log.fault.lr    = p_stack[5];
+  reset_log.fault.pc    = p_stack[6];
+  reset_log.fault.xpsr  = p_stack[7];
+  reset_log.fault.cfsr  = SCB->CFSR;
+  reset_log.fault.hfsr  = SCB->HFSR;
+  reset_log.fault.mmfar = SCB->MMFAR;
+  reset_log.fault.bfar  = SCB->BFAR;
+  reset_log.fault.count = reset_log.count + 1;
+  reset_log.fault.is_valid = true;
+
+  NVIC_SystemReset();
+}
+
+__attribute__((naked)) void HardFault_Handler(void)
+{
+  __asm volatile
+  (
+    "tst   lr, #4             \n"
+    "ite   eq                 \n"
+    "mrseq r0, msp            \n"
+    "mrsne r0, psp            \n"
+    "b     resetFaultHandler  \n"
+  );
+}
+
+
+
+
+#ifdef _USE_HW_CLI
+void cliReset(cli_args_t *args)
+{
+  bool ret = false;
+
+
+  if (args->argc == 1 && args->isStr(0, "info") == true)
+  {
+    cliPrintf("count  : %d\n", reset_log.count);
+    cliPrintf("reason : 0x%02X", reset_log.reason);
+    if (reset_log.reason == 0)
+    {
+      cliPrintf(" /Power On");
+    }
+    for (int i=0; i<8; i++)
+    {
+      if (reset_log.reason & (1<<i))
+      {
+        cliPrintf(" /%s", reset_reason_str[i]);
+      }
+    }
+    cliPrintf("\n");
+
+    // 마지막 리셋이 Fault 때문이 아니면 이전 Fault 로 표시.
+    //
+    if (reset_log.fault.is_valid == true)
+    {
+      if (reset_log.fault.count == reset_log.count)
+      {
+        cliPrintf("fault  : current\n");
+      }
+      else
+      {
+        cliPrintf("fault  : old, reset count %d\n", reset_log.fault.count);
+      }
+      cliPrintf("         pc 0x%08X, lr 0x%08X, xpsr 0x%08X\n",
+                reset_log.fault.pc, reset_log.fault.lr, reset_log.fault.xpsr);
+      cliPrintf("         r0 0x%08X, r1 0x%08X, r2 0x%08X, r3 0x%08X, r12 0x%08X\n",
+                reset_log.fault.r0, reset_log.fault.r1, reset_log.fault.r2, reset_log.fault.r3, reset_log.fault.r12);
+      cliPrintf("         cfsr 0x%08X, hfsr 0x%08X, mmfar 0x%08X, bfar 0x%08X\n",
+                reset_log.fault.cfsr, reset_log.fault.hfsr, reset_log.fault.mmfar, reset_log.fault.bfar);
+    }
+    else
+    {
+      cliPrintf("fault  : none\n");
+    }
+    ret = true;
+  }
+
+  if (args->argc == 1 && args->isStr(0, "log") == true)
+  {
+    uint32_t index;
+    uint32_t length;
+
+    length = min(reset_log.log_in, RESET_LOG_BUF_MAX);
+    index  = reset_log.log_in - length;
+    for (int i=0; i<length; i++)
+    {
+      cliPrintf("%c", reset_log.log_buf[(index + i) % RESET_LOG_BUF_MAX]);
+    }
+    cliPrintf("\n");
+    ret = true;
+  }
+
+  if (args->argc == 1 && args->isStr(0, "clear") == true)
+  {
+    memset(&reset_log.fault, 0, sizeof(reset_fault_t));
+    reset_log.count  = 0;
+    reset_log.log_in = 0;
+    ret = true;
+  }
+
+  // 기록이 남는지 확인용, 잘못된 주소를 읽어서 HardFault 발생
+  //
+  if (args->argc == 1 && args->isStr(0, "fault") == true)
+  {
+    cliPrintf("%d\n", *(volatile uint32_t *)0xFFFFFFF0);
+    ret = true;
+  }
+
+
+  if (ret != true)
+  {
+    cliPrintf("reset info\n");
+    cliPrintf("reset log\n");
+    cliPrintf("reset clear\n");
+    cliPrintf("reset fault\n");
+  }
+}
+#endif
+
+
+#endif
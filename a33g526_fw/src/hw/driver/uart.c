@@ -8,13 +8,15 @@
 
 #include "uart.h"
 #include "qbuffer.h"
+#include "cli.h"
 
 
 #ifdef _USE_HW_UART
 
 
 
-#define UART_RX_BUF_LENGTH      1024
+#define UART_TX_BUF_LENGTH      1024
+#define UART_HW_MAX_CH          4
 
 
 typedef enum
@@ -24,6 +26,21 @@ typedef enum
 } UartHwType_t;
 
 
+typedef struct
+{
+  UART_Type *p_huart;
+  IRQn_Type  irq;
+
+  PCU_Type  *p_rx_port;
+  uint8_t    rx_pin;
+  uint32_t   rx_mux;
+
+  PCU_Type  *p_tx_port;
+  uint8_t    tx_pin;
+  uint32_t   tx_mux;
+} uart_hw_t;
+
+
 typedef struct
 {
   bool     is_open;
@@ -33,13 +50,44 @@ typedef struct
 
   uint8_t  rx_buf[UART_RX_BUF_LENGTH];
   qbuffer_t qbuffer;
+  uint8_t  tx_buf[UART_TX_BUF_LENGTH];
+  qbuffer_t qbuffer_tx;
   UART_Type *p_huart;
   UART_CFG_Type uart_init;
+  const uart_hw_t *p_hw;
+  uart_stat_t stat;
 } uart_tbl_t;
 
 
+static void uartTxStart(uart_tbl_t *p_uart);
+static void uartIrqHandler(uart_tbl_t *p_uart);
+static void uartUpdateLineStat(uart_tbl_t *p_uart, uint32_t lsr_reg);
+
+#ifdef _USE_HW_CLI
+static void cliUart(cli_args_t *args);
+
+CLI_CMD_ADD(uart, cliUart);
+#endif
+
+
 static uart_tbl_t uart_tbl[UART_MAX_CH];
 
+// 채널 번호 순서대로 UART0 ~ UART3 사용 (_DEF_UART1 = UART0)
+//
+static const uart_hw_t uart_hw_tbl[UART_HW_MAX_CH] =
+    {
+        {UART0, UART0_IRQn, PCC, PIN_8,  PC8_MUX_RXD0,  PCC, PIN_9,  PC9_MUX_TXD0},
+        {UART1, UART1_IRQn, PCD, PIN_12, PD12_MUX_RXD1, PCD, PIN_13, PD13_MUX_TXD1},
+        {UART2, UART2_IRQn, PCC, PIN_10, PC10_MUX_RXD2, PCC, PIN_11, PC11_MUX_TXD2},
+        {UART3, UART3_IRQn, PCE, PIN_6,  PE6_MUX_RXD3,  PCE, PIN_7,  PE7_MUX_TXD3},
+    };
+
+#if UART_MAX_CH > UART_HW_MAX_CH
+#error "HW_UART_MAX_CH : 1 ~ 4"
+#endif
+
+extern uint32_t UartBaseClock;
+
 
 
 
@@ -50,6 +98,10 @@ bool uartInit(void)
   {
     uart_tbl[i].is_open = false;
     uart_tbl[i].baud = 57600;
+    uart_tbl[i].type = UART_HW_TYPE_MCU;
+    uart_tbl[i].p_hw = &uart_hw_tbl[i];
+    uart_tbl[i].p_huart = uart_hw_tbl[i].p_huart;
+    memset(&uart_tbl[i].stat, 0, sizeof(uart_stat_t));
   }
 
   return true;
@@ -57,50 +109,50 @@ bool uartInit(void)
 
 bool uartOpen(uint8_t ch, uint32_t baud)
 {
-  bool ret = false;
+  uart_tbl_t *p_uart;
+  const uart_hw_t *p_hw;
 
 
-  switch(ch)
+  if (ch >= UART_MAX_CH)
   {
-    case _DEF_UART1:
-      uart_tbl[ch].type    = UART_HW_TYPE_MCU;
-      uart_tbl[ch].baud    = baud;
-
-      uart_tbl[ch].p_huart                = UART0;
-      uart_tbl[ch].uart_init.Baud_rate    = baud;
-      uart_tbl[ch].uart_init.Databits     = UART_DATABIT_8;
-      uart_tbl[ch].uart_init.Parity       = UART_PARITY_NONE;
-      uart_tbl[ch].uart_init.Stopbits     = UART_STOPBIT_1;
-      uart_tbl[ch].uart_init.RxTxBuffer   = NULL;
-      uart_tbl[ch].uart_init.RxBufferSize = 0;
-      uart_tbl[ch].uart_init.TxBufferSize = 0;
+    return false;
+  }
+  p_uart = &uart_tbl[ch];
+  p_hw   = p_uart->p_hw;
 
+  p_uart->is_open = false;
+  p_uart->baud    = baud;
 
-      qbufferCreate(&uart_tbl[ch].qbuffer, uart_tbl[ch].rx_buf, UART_RX_BUF_LENGTH);
+  p_uart->uart_init.Baud_rate    = baud;
+  p_uart->uart_init.Databits     = UART_DATABIT_8;
+  p_uart->uart_init.Parity       = UART_PARITY_NONE;
+  p_uart->uart_init.Stopbits     = UART_STOPBIT_1;
+  p_uart->uart_init.RxTxBuffer   = NULL;
+  p_uart->uart_init.RxBufferSize = 0;
+  p_uart->uart_init.TxBufferSize = 0;
 
-      PCU_SetDirection(PCC, PIN_8, LOGIC_INPUT);
-      PCU_ConfigureFunction(PCC, PIN_8, PC8_MUX_RXD0);
-      PCU_ConfigurePullupdown(PCC, PIN_8, PULLUP_ENABLE);
 
-      PCU_SetDirection(PCC, PIN_9, PUSHPULL_OUTPUT);
-      PCU_ConfigureFunction(PCC, PIN_9, PC9_MUX_TXD0);
+  qbufferCreate(&p_uart->qbuffer, p_uart->rx_buf, UART_RX_BUF_LENGTH);
+  qbufferCreate(&p_uart->qbuffer_tx, p_uart->tx_buf, UART_TX_BUF_LENGTH);
 
+  PCU_SetDirection(p_hw->p_rx_port, p_hw->rx_pin, LOGIC_INPUT);
+  PCU_ConfigureFunction(p_hw->p_rx_port, p_hw->rx_pin, p_hw->rx_mux);
+  PCU_ConfigurePullupdown(p_hw->p_rx_port, p_hw->rx_pin, PULLUP_ENABLE);
 
-      UART_Init(uart_tbl[ch].p_huart, &uart_tbl[ch].uart_init);
+  PCU_SetDirection(p_hw->p_tx_port, p_hw->tx_pin, PUSHPULL_OUTPUT);
+  PCU_ConfigureFunction(p_hw->p_tx_port, p_hw->tx_pin, p_hw->tx_mux);
 
-      uart_tbl[ch].p_huart->IER = UART_IER_DRIE;
 
-      NVIC_SetPriority(UART0_IRQn, 5);
-      NVIC_EnableIRQ(UART0_IRQn);
+  UART_Init(p_uart->p_huart, &p_uart->uart_init);
 
-      uart_tbl[ch].is_open = true;
+  p_uart->p_huart->IER = UART_IER_DRIE | UART_IER_RLSIE;
 
+  NVIC_SetPriority(p_hw->irq, 5);
+  NVIC_EnableIRQ(p_hw->irq);
 
-      ret = true;
-      break;
-  }
+  p_uart->is_open = true;
 
-  return ret;
+  return true;
 }
 
 bool uartClose(uint8_t ch)
@@ -110,16 +162,12 @@ bool uartClose(uint8_t ch)
 
 uint32_t uartAvailable(uint8_t ch)
 {
-  uint32_t ret = 0;
-
-  switch(ch)
+  if (ch >= UART_MAX_CH)
   {
-    case _DEF_UART1:
-      ret = qbufferAvailable(&uart_tbl[ch].qbuffer);
-      break;
+    return 0;
   }
 
-  return ret;
+  return qbufferAvailable(&uart_tbl[ch].qbuffer);
 }
 
 bool uartFlush(uint8_t ch)
@@ -143,30 +191,119 @@ uint8_t uartRead(uint8_t ch)
 {
   uint8_t ret = 0;
 
-  switch(ch)
+  if (ch < UART_MAX_CH)
   {
-    case _DEF_UART1:
-      qbufferRead(&uart_tbl[ch].qbuffer, &ret, 1);
-      break;
+    qbufferRead(&uart_tbl[ch].qbuffer, &ret, 1);
   }
 
   return ret;
 }
 
+uint32_t uartReadBytes(uint8_t ch, uint8_t *p_data, uint32_t length)
+{
+  if (ch >= UART_MAX_CH)
+  {
+    return 0;
+  }
+
+  return qbufferReadBulk(&uart_tbl[ch].qbuffer, p_data, length);
+}
+
+uint32_t uartGetReadSpan(uint8_t ch, uint8_t **pp_data)
+{
+  if (ch >= UART_MAX_CH)
+  {
+    return 0;
+  }
+
+  return qbufferGetReadSpan(&uart_tbl[ch].qbuffer, pp_data);
+}
+
+void uartConsume(uint8_t ch, uint32_t length)
+{
+  if (ch < UART_MAX_CH)
+  {
+    qbufferConsume(&uart_tbl[ch].qbuffer, length);
+  }
+}
+
 uint32_t uartWrite(uint8_t ch, uint8_t *p_data, uint32_t length)
 {
   uint32_t ret = 0;
+  uint32_t tx_len;
+  uart_tbl_t *p_uart;
+
 
-  switch(ch)
+  if (ch >= UART_MAX_CH || uart_tbl[ch].is_open != true)
   {
-    case _DEF_UART1:
-      ret = (uint32_t)uwrite(uart_tbl[ch].p_huart, (void *)p_data, (int)length);
-      break;
+    return 0;
+  }
+  p_uart = &uart_tbl[ch];
+
+  // 송신 버퍼에 넣고 바로 리턴, 버퍼가 가득 찬 경우에만 빈 공간이 생길 때까지 대기
+  //
+  while(ret < length)
+  {
+    tx_len = min(uartTxAvailable(ch), length - ret);
+    if (tx_len > 0)
+    {
+      qbufferWrite(&p_uart->qbuffer_tx, &p_data[ret], tx_len);
+      ret += tx_len;
+      uartTxStart(p_uart);
+    }
   }
 
   return ret;
 }
 
+uint32_t uartTxAvailable(uint8_t ch)
+{
+  if (ch >= UART_MAX_CH)
+  {
+    return 0;
+  }
+
+  return qbufferFree(&uart_tbl[ch].qbuffer_tx);
+}
+
+bool uartFlushTx(uint8_t ch)
+{
+  uart_tbl_t *p_uart;
+
+
+  if (ch >= UART_MAX_CH || uart_tbl[ch].is_open != true)
+  {
+    return false;
+  }
+  p_uart = &uart_tbl[ch];
+
+  // 송신 버퍼와 송신 레지스터가 모두 비워질 때까지 대기
+  //
+  while(qbufferAvailable(&p_uart->qbuffer_tx) > 0);
+  while((p_uart->p_huart->LSR & UART_LSR_TEMT) == 0);
+
+  return true;
+}
+
+void uartTxStart(uart_tbl_t *p_uart)
+{
+  uint8_t tx_data;
+
+  // THRE 인터럽트가 꺼져 있으면 송신이 멈춘 상태이므로 첫 바이트를 직접 써서 시작
+  //
+  __disable_irq();
+  if ((p_uart->p_huart->IER & UART_IER_THREIE) == 0)
+  {
+    if (qbufferRead(&p_uart->qbuffer_tx, &tx_data, 1) == true)
+    {
+      p_uart->p_huart->THR = tx_data;
+      p_uart->p_huart->IER |= UART_IER_THREIE;
+      p_uart->stat.tx_cnt++;
+    }
+  }
+  __enable_irq();
+}
+
 uint32_t uartPrintf(uint8_t ch, const char *fmt, ...)
 {
   char buf[256];
@@ -187,41 +324,268 @@ uint32_t uartPrintf(uint8_t ch, const char *fmt, ...)
 
 uint32_t uartGetBaud(uint8_t ch)
 {
-  uint32_t ret = 0;
+  if (ch >= UART_MAX_CH)
+  {
+    return 0;
+  }
+
+  return uart_tbl[ch].baud;
+}
+
+//
+// UartBaseClock = SystemPeriClock / 2 = 37MHz (74MHz 기준)
+// 분주비 = UartBaseClock / (16 * baud), 정수부 DLL/DLM + 소수부 BFR(1/256)
+//
+//     baud    DLL  BFR    실제 baud   오차
+//     9600    240  226        9600   0.00%
+//    57600     40   37       57604   0.01%
+//   115200     20   18      115220   0.02%
+//   230400     10    9      230440   0.02%
+//   460800      5    4      461059   0.06%
+//   500000      4  160      500000   0.00%
+//   921600      2  130      922118   0.06%
+//  1000000      2   80     1000000   0.00%
+//  1500000      1  138     1502538   0.17%
+//  2000000      1   40     2000000   0.00%
+//
+uint32_t uartGetBaudError(uint8_t ch, uint32_t baud)
+{
+  uint32_t div;
+  uint32_t baud_real;
+  uint32_t err;
 
 
-  switch(ch)
+  // 분주비를 1/256 단위로 계산 (UART_SetDivisors() 와 같은 방식)
+  //
+  if (baud == 0)
   {
-    case _DEF_UART1:
-      ret = uart_tbl[ch].baud;
-      break;
+    return 0xFFFFFFFF;
+  }
+  div = (uint32_t)(((uint64_t)UartBaseClock * 256) / (16 * baud));
+  if (div < 256)
+  {
+    return 0xFFFFFFFF;
   }
 
-  return ret;
+  baud_real = (uint32_t)(((uint64_t)UartBaseClock * 256) / (16 * div));
+  err = (baud_real > baud) ? (baud_real - baud) : (baud - baud_real);
+
+  return (uint32_t)(((uint64_t)err * 10000) / baud);   // 0.01% 단위
 }
 
+bool uartSetBaud(uint8_t ch, uint32_t baud)
+{
+  uart_tbl_t *p_uart;
 
 
+  if (uartGetBaudError(ch, baud) > UART_BAUD_ERR_MAX)
+  {
+    return false;
+  }
+  if (ch >= UART_MAX_CH || uart_tbl[ch].is_open != true)
+  {
+    return false;
+  }
+  p_uart = &uart_tbl[ch];
 
+  // 보내고 있는 데이터가 모두 나간 후에 변경
+  //
+  uartFlushTx(ch);
 
-void UART_0_Handler(void)
+  UART_SetDivisors(p_uart->p_huart, baud);
+  p_uart->baud = baud;
+  p_uart->uart_init.Baud_rate = baud;
+
+  return true;
+}
+
+bool uartGetStat(uint8_t ch, uart_stat_t *p_stat)
+{
+  if (ch >= UART_MAX_CH)
+  {
+    return false;
+  }
+
+  __disable_irq();
+  *p_stat = uart_tbl[ch].stat;
+  __enable_irq();
+
+  return true;
+}
+
+void uartClearStat(uint8_t ch)
+{
+  if (ch >= UART_MAX_CH)
+  {
+    return;
+  }
+
+  __disable_irq();
+  memset(&uart_tbl[ch].stat, 0, sizeof(uart_stat_t));
+  __enable_irq();
+}
+
+
+
+
+void uartIrqHandler(uart_tbl_t *p_uart)
 {
-  uart_tbl_t *p_uart = &uart_tbl[_DEF_UART1];
   uint32_t iir_reg;
   uint32_t isr_id;
+  uint32_t lsr_reg;
 
+  // FIFO 가 없어서 수신은 1바이트마다 인터럽트가 발생하므로
+  // 한번 들어왔을 때 라인 에러, 수신, 송신을 모두 처리해서 다시 들어오는 횟수를 줄인다.
+  //
   iir_reg = p_uart->p_huart->IIR;
   isr_id  = iir_reg & 0x07;
 
+  // 라인 에러(Overrun/Parity/Framing) : LSR 을 읽으면 에러가 지워지고, 받은 데이터는 그대로 넣는다.
+  //
+  if (isr_id == 0x06)
+  {
+    lsr_reg = p_uart->p_huart->LSR;
+    uartUpdateLineStat(p_uart, lsr_reg);
+    if (lsr_reg & UART_LSR_RDR)
+    {
+      isr_id = 0x04;
+    }
+  }
+
   if (isr_id == 0x04)
   {
     uint8_t read_data;
 
+    uint32_t rx_len;
+
     read_data = p_uart->p_huart->RBR;
-    qbufferWrite(&p_uart->qbuffer, &read_data, 1);
+    p_uart->stat.rx_cnt++;
+    if (qbufferWrite(&p_uart->qbuffer, &read_data, 1) != true)
+    {
+      p_uart->stat.rx_drop_cnt++;
+    }
+
+    rx_len = qbufferAvailable(&p_uart->qbuffer);
+    if (rx_len > p_uart->stat.rx_peak)
+    {
+      p_uart->stat.rx_peak = rx_len;
+    }
+  }
+
+  if (p_uart->p_huart->IER & UART_IER_THREIE)
+  {
+    lsr_reg = p_uart->p_huart->LSR;
+    uartUpdateLineStat(p_uart, lsr_reg);
+    if (isr_id == 0x02 || (lsr_reg & UART_LSR_THRE))
+    {
+      uint8_t tx_data;
+
+      if (qbufferRead(&p_uart->qbuffer_tx, &tx_data, 1) == true)
+      {
+        p_uart->p_huart->THR = tx_data;
+        p_uart->stat.tx_cnt++;
+      }
+      else
+      {
+        p_uart->p_huart->IER &= ~UART_IER_THREIE;
+      }
+    }
+  }
+}
+
+// LSR 을 읽으면 에러 비트가 지워지므로 읽을 때마다 누적
+//
+void uartUpdateLineStat(uart_tbl_t *p_uart, uint32_t lsr_reg)
+{
+  if (lsr_reg & UART_LSR_OE)
+  {
+    p_uart->stat.overrun_cnt++;
   }
-  return;
+  if (lsr_reg & UART_LSR_PE)
+  {
+    p_uart->stat.parity_err_cnt++;
+  }
+  if (lsr_reg & UART_LSR_FE)
+  {
+    p_uart->stat.frame_err_cnt++;
+  }
+}
+
+// 사용하지 않는 채널의 핸들러는 startup 의 Default_Handler 를 사용
+//
+void UART_0_Handler(void)
+{
+  uartIrqHandler(&uart_tbl[_DEF_UART1]);
+}
+
+#if UART_MAX_CH > 1
+void UART_1_Handler(void)
+{
+  uartIrqHandler(&uart_tbl[_DEF_UART2]);
 }
+#endif
+
+#if UART_MAX_CH > 2
+void UART_2_Handler(void)
+{
+  uartIrqHandler(&uart_tbl[_DEF_UART3]);
+}
+#endif
+
+#if UART_MAX_CH > 3
+void UART_3_Handler(void)
+{
+  uartIrqHandler(&uart_tbl[_DEF_UART4]);
+}
+#endif
+
+
+
+
+#ifdef _USE_HW_CLI
+void cliUart(cli_args_t *args)
+{
+  bool ret = false;
+  uart_stat_t stat;
+
+
+  if (args->argc == 1 && args->isStr(0, "stat") == true)
+  {
+    for (int i=0; i<UART_MAX_CH; i++)
+    {
+      uartGetStat(i, &stat);
+
+      cliPrintf("uart %d : %s, %d bps\n", i+1, uart_tbl[i].is_open ? "open":"close", uart_tbl[i].baud);
+      cliPrintf("  rx      : %u\n", stat.rx_cnt);
+      cliPrintf("  tx      : %u\n", stat.tx_cnt);
+      cliPrintf("  rx drop : %u\n", stat.rx_drop_cnt);
+      cliPrintf("  overrun : %u\n", stat.overrun_cnt);
+      cliPrintf("  parity  : %u\n", stat.parity_err_cnt);
+      cliPrintf("  frame   : %u\n", stat.frame_err_cnt);
+      cliPrintf("  rx peak : %u/%u\n", stat.rx_peak, UART_RX_BUF_LENGTH);
+    }
+
+    ret = true;
+  }
+
+  if (args->argc == 1 && args->isStr(0, "clear") == true)
+  {
+    for (int i=0; i<UART_MAX_CH; i++)
+    {
+      uartClearStat(i);
+    }
+
+    ret = true;
+  }
+
+
+  if (ret != true)
+  {
+    cliPrintf("uart stat\n");
+    cliPrintf("uart clear\n");
+  }
+}
+#endif
 
 
 #endif
@@ -42,6 +42,7 @@ bool hwInit(void)
   bspInit();
 
   cliInit();
+  resetInit();
   logInit();
   ledInit();
   buttonInit();
@@ -51,6 +52,7 @@ bool hwInit(void)
   logPrintf("[ Firmware Begin... ]\r\n");
   logPrintf("Booting..Name \t\t: %s\r\n", _DEF_BOARD_NAME);
   logPrintf("Booting..Ver  \t\t: %s\r\n", _DEF_FIRMWATRE_VERSION);
+  logPrintf("Booting..Reset\t\t: 0x%02X, %d\r\n", resetGetReason(), resetGetCount());
 
   flashInit();
 
@@ -17,6 +17,7 @@
 #include "button.h"
 #include "flash.h"
 #include "cli.h"
+#include "reset.h"
 
 
 bool hwInit(void);
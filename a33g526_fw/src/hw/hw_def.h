@@ -17,6 +17,9 @@
 
 #define _USE_HW_FLASH
 
+#define _USE_HW_RESET
+#define      HW_RESET_LOG_BUF_MAX   256
+
 #define _USE_HW_LED
 #define      HW_LED_MAX_CH          6
 
@@ -25,12 +28,14 @@
 
 #define _USE_HW_LOG
 #define      HW_LOG_CH              _DEF_UART1
+#define _USE_HW_LOG_DEFER
+#define      HW_LOG_DEFER_BUF_MAX   256
+#define      HW_LOG_LEVEL           LOG_LEVEL_INFO
 
 #define _USE_HW_BUTTON
 #define      HW_BUTTON_MAX_CH       1
 
 #define _USE_HW_CLI
-#define      HW_CLI_CMD_LIST_MAX    16
 #define      HW_CLI_CMD_NAME_MAX    16
 #define      HW_CLI_LINE_HIS_MAX    4
 #define      HW_CLI_LINE_BUF_MAX    64
@@ -0,0 +1,688 @@
+/*
+ * bootsim.c
+ *
+ *  Created on: 2021. 8. 13.
+ *      Author: baram
+ *
+ *  부트로더 호스트(Linux) 시뮬레이션
+ *
+ *  build : gcc -O2 -no-pie -pthread -I. -I../../a33g526_boot/src -I../../a33g526_boot/src/common
+ *              -I../../a33g526_boot/src/common/core -I../../a33g526_boot/src/common/hw/include
+ *              -I../../a33g526_boot/src/hw -I../../a33g526_boot/src/ap bootsim.c
+ *              ../../a33g526_boot/src/ap/ap.c ../../a33g526_boot/src/ap/boot/boot.c ../../a33g526_boot/src/hw/hw.c
+ *              ../../a33g526_boot/src/hw/driver/cmd.c ../../a33g526_boot/src/hw/driver/flash.c
+ *              ../../a33g526_boot/src/hw/driver/uart.c ../../a33g526_boot/src/hw/driver/log.c
+ *              ../../a33g526_boot/src/common/core/qbuffer.c ../../a33g526_boot/src/common/core/util.c
+ *              ../../a33g526_boot/src/common/core/crc.c ../../a33g526_boot/src/common/core/lz.c
+ *              ../../a33g526_boot/src/common/core/delta.c -o bootsim
+ *  usage : bootsim [-p link] [-f flash.bin] [-e erase_us] [-w program_us] [-d addr] [-b] [-x]
+ *
+ *          -p : pty 의 심볼릭 링크 이름 (없으면 pty 이름만 출력)
+ *          -f : Flash 이미지 파일 (256KB, 없으면 만들고 종료 후에도 유지)
+ *          -e : 섹터 Erase 시간 (us)
+ *          -w : 워드 Program 시간 (us)
+ *          -d : 이 주소의 워드는 Program 이 실패 (불량 워드 흉내, Write 에러 처리 확인용)
+ *          -b : 버튼을 누른 상태로 시작 (부트로더 모드)
+ *          -x : 펌웨어로 점프하면 종료 (기본은 버튼을 누른 상태로 리셋)
+ *
+ *  bsp.h 를 이 폴더의 것으로 바꿔서 부트로더 소스를 그대로 빌드한다.
+ *  Flash 주소를 포인터로 쓰므로 -no-pie 로 빌드 (포인터/정수 변환 경고는 무시)
+ *
+ *  - Flash : 부트로더가 주소로 직접 읽으므로 실제 주소(0x7000~)에 읽기 전용으로 맵핑하고,
+ *            Erase/Program 은 FMC 흉내 함수에서만 쓴다. 지우지 않은 워드에 Program 하면 거부.
+ *            (vm.mmap_min_addr 이 0x7000 보다 크면 sysctl vm.mmap_min_addr=4096 필요)
+ *            0x7000 아래의 부트로더 코드 영역은 없으므로 FLASH_READ 로 읽으면 Segfault.
+ *  - RAM   : FLASH_READ 로 읽을 수 있도록 RAM_ADDR_START~ 에 0 으로 채운 영역만 맵핑 (변수는 호스트 메모리)
+ *  - UART0 : pty, 설정된 baud 기준으로 RX/TX 시간을 맞추고 RX/THRE 인터럽트는 쓰레드에서 UART_0_Handler() 호출.
+ *            FIFO 없이 RBR 1바이트, THR 1바이트 + 시프트 레지스터. 인터럽트 횟수는 bspDeInit() 에서 출력.
+ *            __disable_irq()/__enable_irq() 는 인터럽트 쓰레드와의 mutex.
+ *            호스트쪽 termios 속도는 확인하지 않는다.
+ *  - millis() : CLOCK_MONOTONIC, 리셋 후 0 부터
+ *  - bootJumpToFw() : bspDeInit() 에서 펌웨어 대신 리셋으로 돌아온다.
+ */
+
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/prctl.h>
+
+#include "main.h"
+
+
+#define SIM_FLASH_LENGTH        (256*1024)
+#define SIM_FLASH_SECTOR        1024
+#define SIM_FLASH_MAP_ADDR      0x7000          // FLASH_ADDR_BOOT_INFO 가 들어있는 페이지부터
+#define SIM_FLASH_ERASE_US      2000            // 섹터 Erase
+#define SIM_FLASH_PROGRAM_US    40              // 워드 Program
+
+#define SIM_UART_THR_EMPTY      0x100           // THR 에 보낼 데이터가 없음
+
+
+typedef struct
+{
+  uint32_t erase_cnt;
+  uint32_t program_cnt;
+  uint32_t err_cnt;
+  uint64_t busy_us;
+} sim_flash_t;
+
+typedef struct
+{
+  uint32_t isr_cnt;
+  uint32_t rx_cnt;
+  uint32_t tx_cnt;
+  uint32_t isr_peak;                            // 1초 동안 가장 많이 들어온 인터럽트 수
+  uint32_t window_cnt;
+  uint64_t window_start;
+} sim_uart_t;
+
+
+static void     simWait(uint64_t *p_until, uint64_t time_us);
+static uint64_t simMicros(void);
+static bool     simFlashOpen(const char *name);
+static bool     simUartOpen(const char *link_name);
+static void    *simUartRxThread(void *arg);
+static void    *simUartTxThread(void *arg);
+static void     simUartIsr(uint32_t iir);
+static void     simUartThrCheck(void);
+
+void UART_0_Handler(void);
+
+
+uint32_t SystemCoreClock = 74000000;
+uint32_t UartBaseClock   = 74000000/2;
+
+static FMC_Type  fmc_reg;
+
+UART_Type  sim_uart_reg[4];
+FMC_Type  *FMC   = &fmc_reg;
+
+
+static uint8_t    *sim_flash;                   // 쓰기용 맵핑 (0 번지부터)
+static sim_flash_t sim_flash_info;
+static uint64_t    sim_flash_busy;
+static uint32_t    sim_flash_erase_us   = SIM_FLASH_ERASE_US;
+static uint32_t    sim_flash_program_us = SIM_FLASH_PROGRAM_US;
+static uint32_t    sim_flash_bad_addr   = 0xFFFFFFFF;
+
+static int         sim_pty_fd = -1;
+static int         sim_pty_slave_fd = -1;
+static volatile uint32_t sim_baud = 115200;
+static uint64_t    sim_tx_busy;
+static uint32_t    sim_tx_drop;
+static uint64_t    sim_rx_busy;
+static sim_uart_t  sim_uart_info;
+static bool        sim_irq_enable = false;
+static pthread_mutex_t sim_irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  sim_tx_cond  = PTHREAD_COND_INITIALIZER;
+
+static uint64_t    sim_time_base;
+static bool        sim_button = false;
+static bool        sim_exit_on_jump = false;
+static jmp_buf     sim_reset;
+
+
+
+
+int main(int argc, char *argv[])
+{
+  const char *link_name  = NULL;
+  const char *flash_name = NULL;
+  int opt;
+
+
+  while((opt = getopt(argc, argv, "p:f:e:w:d:bx")) != -1)
+  {
+    switch(opt)
+    {
+      case 'p':
+        link_name = optarg;
+        break;
+
+      case 'f':
+        flash_name = optarg;
+        break;
+
+      case 'e':
+        sim_flash_erase_us = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+
+      case 'w':
+        sim_flash_program_us = (uint32_t)strtoul(optarg, NULL, 0);
+        break;
+
+      case 'd':
+        sim_flash_bad_addr = (uint32_t)strtoul(optarg, NULL, 0) & ~0x03;
+        break;
+
+      case 'b':
+        sim_button = true;
+        break;
+
+      case 'x':
+        sim_exit_on_jump = true;
+        break;
+
+      default:
+        printf("bootsim [-p link] [-f flash.bin] [-e erase_us] [-w program_us] [-d addr] [-b] [-x]\n");
+        return 1;
+    }
+  }
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+
+  // 워드 Program 처럼 짧은 대기가 늦어지지 않도록
+  prctl(PR_SET_TIMERSLACK, 1);
+
+  if (simFlashOpen(flash_name) != true || simUartOpen(link_name) != true)
+  {
+    return 1;
+  }
+
+  printf("[sim] flash erase %uus/sector, program %uus/word\n", sim_flash_erase_us, sim_flash_program_us);
+
+  setjmp(sim_reset);
+
+  printf("[sim] reset, button %s\n", sim_button ? "pressed":"released");
+
+  hwInit();
+  apInit();
+
+  apMain();
+
+  return 0;
+}
+
+
+
+
+bool ledInit(void)
+{
+  return true;
+}
+
+void ledOn(uint8_t ch)
+{
+}
+
+void ledOff(uint8_t ch)
+{
+}
+
+void ledToggle(uint8_t ch)
+{
+}
+
+bool buttonInit(void)
+{
+  return true;
+}
+
+bool buttonGetPressed(uint8_t ch)
+{
+  return sim_button;
+}
+
+
+
+
+bool bspInit(void)
+{
+  sim_time_base = simMicros();
+
+  memset(&sim_flash_info, 0, sizeof(sim_flash_info));
+  memset(&sim_uart_info, 0, sizeof(sim_uart_info));
+
+  return true;
+}
+
+void bspDeInit(void)
+{
+  pthread_mutex_lock(&sim_irq_lock);
+  sim_irq_enable = false;
+  pthread_mutex_unlock(&sim_irq_lock);
+
+  printf("[sim] jump to fw 0x%X at %ums, uart tx drop %u\n", *(uint32_t *)(FLASH_ADDR_FW + 4), millis(), sim_tx_drop);
+  printf("[sim] flash erase %u, program %u, error %u, busy %ums\n",
+         sim_flash_info.erase_cnt,
+         sim_flash_info.program_cnt,
+         sim_flash_info.err_cnt,
+         (uint32_t)(sim_flash_info.busy_us / 1000));
+  printf("[sim] uart isr %u, rx %u, tx %u bytes, peak %u isr/s at %u baud\n",
+         sim_uart_info.isr_cnt,
+         sim_uart_info.rx_cnt,
+         sim_uart_info.tx_cnt,
+         sim_uart_info.isr_peak,
+         sim_baud);
+  {
+    uart_stat_t stat;
+
+    uartGetStat(_DEF_UART1, &stat);
+    printf("[sim] uart stat rx %u, tx %u, rx drop %u, rx peak %u\n",
+           stat.rx_cnt,
+           stat.tx_cnt,
+           stat.rx_drop_cnt,
+           stat.rx_peak);
+  }
+
+  if (sim_exit_on_jump == true)
+  {
+    exit(0);
+  }
+
+  // 펌웨어를 실행할 수 없으므로 버튼을 누른 상태로 리셋
+  sim_button = true;
+  longjmp(sim_reset, 1);
+}
+
+void delay(uint32_t ms)
+{
+  usleep(ms * 1000);
+}
+
+uint32_t millis(void)
+{
+  return (uint32_t)((simMicros() - sim_time_base) / 1000);
+}
+
+uint64_t simMicros(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+// 연속된 동작은 이전 완료 시간에 이어서 계산하여 sleep 오차가 누적되지 않도록 한다.
+//
+void simWait(uint64_t *p_until, uint64_t time_us)
+{
+  uint64_t cur_time;
+  struct timespec ts;
+
+
+  cur_time = simMicros();
+  if (*p_until + 1000 < cur_time)
+  {
+    *p_until = cur_time;
+  }
+  *p_until += time_us;
+
+  if (*p_until > cur_time)
+  {
+    ts.tv_sec  = (time_t)(*p_until / 1000000);
+    ts.tv_nsec = (long)(*p_until % 1000000) * 1000;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+  }
+}
+
+
+
+
+bool simFlashOpen(const char *name)
+{
+  int fd;
+  struct stat st;
+  void *p_map;
+
+
+  if (name != NULL)
+  {
+    fd = open(name, O_RDWR | O_CREAT, 0644);
+  }
+  else
+  {
+    fd = memfd_create("bootsim_flash", 0);
+  }
+  if (fd < 0 || fstat(fd, &st) != 0)
+  {
+    printf("[sim] flash open fail : %s\n", name ? name:"memfd");
+    return false;
+  }
+
+  if (st.st_size < SIM_FLASH_LENGTH)
+  {
+    uint8_t erased[SIM_FLASH_SECTOR];
+
+    memset(erased, 0xFF, sizeof(erased));
+    for (uint32_t addr = (uint32_t)st.st_size & ~(SIM_FLASH_SECTOR-1); addr < SIM_FLASH_LENGTH; addr += SIM_FLASH_SECTOR)
+    {
+      if (pwrite(fd, erased, SIM_FLASH_SECTOR, addr) != SIM_FLASH_SECTOR)
+      {
+        printf("[sim] flash init fail\n");
+        return false;
+      }
+    }
+  }
+
+  sim_flash = mmap(NULL, SIM_FLASH_LENGTH, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (sim_flash == MAP_FAILED)
+  {
+    printf("[sim] flash mmap fail\n");
+    return false;
+  }
+
+  // 부트로더가 읽는 주소, 직접 쓰면 Segfault (보드의 HardFault 대신)
+  //
+  p_map = mmap((void *)SIM_FLASH_MAP_ADDR, SIM_FLASH_LENGTH - SIM_FLASH_MAP_ADDR,
+               PROT_READ, MAP_SHARED | MAP_FIXED_NOREPLACE, fd, SIM_FLASH_MAP_ADDR);
+  if (p_map != (void *)SIM_FLASH_MAP_ADDR)
+  {
+    printf("[sim] flash map fail at 0x%X : %s\n", SIM_FLASH_MAP_ADDR, strerror(errno));
+    printf("[sim]   sysctl vm.mmap_min_addr=4096\n");
+    return false;
+  }
+
+  p_map = mmap((void *)RAM_ADDR_START, RAM_ADDR_END - RAM_ADDR_START,
+               PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  if (p_map != (void *)RAM_ADDR_START)
+  {
+    printf("[sim] ram map fail at 0x%X : %s\n", RAM_ADDR_START, strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+int FLASH_Self_EraseSector(FMC_Type * const flash, uint32_t addr)
+{
+  if ((flash->TEST & 0xFFFF0000) != FMTEST_WRITE_KEY ||
+      addr % SIM_FLASH_SECTOR != 0 ||
+      addr < FLASH_ADDR_BOOT_INFO ||
+      addr >= SIM_FLASH_LENGTH)
+  {
+    printf("[sim] erase fail : 0x%X\n", addr);
+    sim_flash_info.err_cnt++;
+    return -1;
+  }
+
+  simWait(&sim_flash_busy, sim_flash_erase_us);
+
+  memset(&sim_flash[addr], 0xFF, SIM_FLASH_SECTOR);
+  sim_flash_info.erase_cnt++;
+  sim_flash_info.busy_us += sim_flash_erase_us;
+
+  return 0;
+}
+
+// Data Flash 는 흉내내지 않는다. (부트로더는 사용하지 않음)
+//
+int FLASH_EraseSector(FMC_Type * const flash, uint32_t addr)
+{
+  printf("[sim] data flash erase fail : 0x%X\n", addr);
+  sim_flash_info.err_cnt++;
+  return -1;
+}
+
+int FLASH_ProgramByte(FMC_Type * const flash, uint32_t addr, uint8_t data)
+{
+  printf("[sim] data flash program fail : 0x%X\n", addr);
+  sim_flash_info.err_cnt++;
+  return -1;
+}
+
+int FLASH_Self_ProgramWORD(FMC_Type * const flash, uint32_t addr, uint32_t data)
+{
+  uint32_t *p_word;
+
+
+  if ((flash->TEST & 0xFFFF0000) != FMTEST_WRITE_KEY ||
+      addr % 4 != 0 ||
+      addr < FLASH_ADDR_BOOT_INFO ||
+      addr >= SIM_FLASH_LENGTH)
+  {
+    printf("[sim] program fail : 0x%X\n", addr);
+    sim_flash_info.err_cnt++;
+    return -1;
+  }
+
+  p_word = (uint32_t *)&sim_flash[addr];
+  if (*p_word != 0xFFFFFFFF)
+  {
+    printf("[sim] program fail : 0x%X not erased (0x%08X <- 0x%08X)\n", addr, *p_word, data);
+    sim_flash_info.err_cnt++;
+    return -1;
+  }
+
+  simWait(&sim_flash_busy, sim_flash_program_us);
+
+  // 불량 워드는 Program 이 끝나도 지운 상태로 남는다. (다시 읽어야 알 수 있음)
+  if (addr == sim_flash_bad_addr)
+  {
+    return 0;
+  }
+
+  *p_word = data;
+  sim_flash_info.program_cnt++;
+  sim_flash_info.busy_us += sim_flash_program_us;
+
+  return 0;
+}
+
+
+
+
+bool simUartOpen(const char *link_name)
+{
+  pthread_t thread;
+  struct termios tio;
+  const char *slave_name;
+
+
+  sim_pty_fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (sim_pty_fd < 0 || grantpt(sim_pty_fd) != 0 || unlockpt(sim_pty_fd) != 0)
+  {
+    printf("[sim] pty open fail\n");
+    return false;
+  }
+  slave_name = ptsname(sim_pty_fd);
+
+  // 읽어가지 않아서 pty 버퍼가 차면 송신 데이터는 버린다. (실제 UART 와 같이)
+  fcntl(sim_pty_fd, F_SETFL, fcntl(sim_pty_fd, F_GETFL) | O_NONBLOCK);
+
+  // 호스트쪽이 닫혀 있어도 EIO 가 나지 않도록 직접 열어둔다.
+  sim_pty_slave_fd = open(slave_name, O_RDWR | O_NOCTTY);
+  if (sim_pty_slave_fd >= 0 && tcgetattr(sim_pty_slave_fd, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    tcsetattr(sim_pty_slave_fd, TCSANOW, &tio);
+  }
+
+  if (link_name != NULL)
+  {
+    unlink(link_name);
+    if (symlink(slave_name, link_name) != 0)
+    {
+      printf("[sim] link fail : %s\n", link_name);
+      return false;
+    }
+    printf("[sim] uart : %s -> %s\n", link_name, slave_name);
+  }
+  else
+  {
+    printf("[sim] uart : %s\n", slave_name);
+  }
+
+  if (pthread_create(&thread, NULL, simUartRxThread, NULL) != 0 ||
+      pthread_create(&thread, NULL, simUartTxThread, NULL) != 0)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+void *simUartRxThread(void *arg)
+{
+  uint8_t buf[256];
+  ssize_t len;
+  struct pollfd fds;
+
+
+  fds.fd     = sim_pty_fd;
+  fds.events = POLLIN;
+
+  while(1)
+  {
+    if (poll(&fds, 1, 100) <= 0)
+    {
+      continue;
+    }
+
+    len = read(sim_pty_fd, buf, sizeof(buf));
+    if (len <= 0)
+    {
+      usleep(10*1000);
+      continue;
+    }
+
+    for (int i=0; i<len; i++)
+    {
+      // 1바이트 = 10비트 (8N1)
+      simWait(&sim_rx_busy, 10 * 1000000 / sim_baud);
+
+      pthread_mutex_lock(&sim_irq_lock);
+      sim_uart_info.rx_cnt++;
+      if (sim_irq_enable == true && (UART0->IER & UART_IER_DRIE))
+      {
+        UART0->RBR = buf[i];
+        UART0->LSR |= UART_LSR_RDR;
+        simUartIsr(0x04);
+        UART0->LSR &= ~UART_LSR_RDR;
+      }
+      pthread_mutex_unlock(&sim_irq_lock);
+    }
+  }
+
+  return NULL;
+}
+
+void *simUartTxThread(void *arg)
+{
+  uint8_t tx_data;
+
+
+  pthread_mutex_lock(&sim_irq_lock);
+  while(1)
+  {
+    if (UART0->THR == SIM_UART_THR_EMPTY)
+    {
+      UART0->LSR |= UART_LSR_TEMT;
+      pthread_cond_wait(&sim_tx_cond, &sim_irq_lock);
+      continue;
+    }
+    // THR -> 시프트 레지스터, 보내는 동안 THR 에 다음 바이트를 넣을 수 있다.
+    tx_data = (uint8_t)UART0->THR;
+    UART0->THR = SIM_UART_THR_EMPTY;
+    UART0->LSR |= UART_LSR_THRE;
+    UART0->LSR &= ~UART_LSR_TEMT;
+    sim_uart_info.tx_cnt++;
+    pthread_mutex_unlock(&sim_irq_lock);
+
+    // 받는 쪽이 읽지 않아서 pty 버퍼가 가득 차면 버린다.
+    if (write(sim_pty_fd, &tx_data, 1) != 1)
+    {
+      sim_tx_drop++;
+    }
+    simWait(&sim_tx_busy, 10 * 1000000 / sim_baud);
+
+    // 1바이트를 다 보냈을 때 THR 이 비어 있으면 THRE 인터럽트
+    pthread_mutex_lock(&sim_irq_lock);
+    if (sim_irq_enable == true && (UART0->IER & UART_IER_THREIE) && UART0->THR == SIM_UART_THR_EMPTY)
+    {
+      simUartIsr(0x02);
+    }
+  }
+
+  return NULL;
+}
+
+// sim_irq_lock 을 잡은 상태에서 호출
+//
+void simUartIsr(uint32_t iir)
+{
+  uint64_t time_us;
+
+  time_us = simMicros();
+  if (time_us - sim_uart_info.window_start >= 1000000)
+  {
+    sim_uart_info.window_start = time_us;
+    sim_uart_info.window_cnt = 0;
+  }
+  sim_uart_info.window_cnt++;
+  sim_uart_info.isr_peak = max(sim_uart_info.isr_peak, sim_uart_info.window_cnt);
+  sim_uart_info.isr_cnt++;
+
+  UART0->IIR = iir;
+  UART_0_Handler();
+  UART0->IIR = 0x01;
+
+  simUartThrCheck();
+}
+
+// THR 에 쓰면 바로 THRE/TEMT 가 꺼지도록
+//
+void simUartThrCheck(void)
+{
+  if (UART0->THR != SIM_UART_THR_EMPTY)
+  {
+    UART0->LSR &= ~(UART_LSR_THRE | UART_LSR_TEMT);
+    pthread_cond_signal(&sim_tx_cond);
+  }
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+  if (irq != UART0_IRQn)
+  {
+    return;
+  }
+  pthread_mutex_lock(&sim_irq_lock);
+  sim_irq_enable = true;
+  pthread_mutex_unlock(&sim_irq_lock);
+}
+
+void __disable_irq(void)
+{
+  pthread_mutex_lock(&sim_irq_lock);
+}
+
+void __enable_irq(void)
+{
+  simUartThrCheck();
+  pthread_mutex_unlock(&sim_irq_lock);
+}
+
+void UART_Init(UART_Type *UARTn, UART_CFG_Type *UART_ConfigStruct)
+{
+  pthread_mutex_lock(&sim_irq_lock);
+  UARTn->IER = 0;
+  UARTn->IIR = 0x01;
+  UARTn->THR = SIM_UART_THR_EMPTY;
+  UARTn->LSR = UART_LSR_THRE | UART_LSR_TEMT;
+  pthread_mutex_unlock(&sim_irq_lock);
+
+  if (UARTn == UART0)
+  {
+    sim_baud = UART_ConfigStruct->Baud_rate;
+  }
+}
+
+void UART_SetDivisors(UART_Type *UARTn, uint32_t baudrate)
+{
+  if (UARTn == UART0)
+  {
+    sim_baud = baudrate;
+  }
+}
@@ -0,0 +1,171 @@
+/*
+ * bsp.h
+ *
+ *  Created on: 2021. 8. 13.
+ *      Author: baram
+ *
+ *  bootsim 용 bsp.h
+ *  a33g526_boot/src/bsp/bsp.h 대신 사용되며, 부트로더가 사용하는 HAL 만 흉내낸다.
+ */
+
+#ifndef TOOLS_BOOTSIM_BSP_H_
+#define TOOLS_BOOTSIM_BSP_H_
+
+#include "def.h"
+
+
+
+//
+// UART
+//
+typedef struct
+{
+  volatile uint32_t RBR;
+  volatile uint32_t THR;
+  volatile uint32_t IER;
+  volatile uint32_t IIR;
+  volatile uint32_t LSR;
+} UART_Type;
+
+typedef enum
+{
+  UART_DATABIT_8 = 3,
+} UART_DATABIT_Type;
+
+typedef enum
+{
+  UART_PARITY_NONE = 0,
+} UART_PARITY_Type;
+
+typedef enum
+{
+  UART_STOPBIT_1 = 0,
+} UART_STOPBIT_Type;
+
+typedef struct
+{
+  uint32_t          Baud_rate;
+  UART_DATABIT_Type Databits;
+  UART_PARITY_Type  Parity;
+  UART_STOPBIT_Type Stopbits;
+
+  uint8_t  *RxTxBuffer;
+  uint16_t  RxBufferSize;
+  uint16_t  TxBufferSize;
+} UART_CFG_Type;
+
+#define UART_IER_DRIE           (1<<0)
+#define UART_IER_THREIE         (1<<1)
+#define UART_IER_RLSIE          (1<<2)
+#define UART_LSR_RDR            (1<<0)
+#define UART_LSR_OE             (1<<1)
+#define UART_LSR_PE             (1<<2)
+#define UART_LSR_FE             (1<<3)
+#define UART_LSR_THRE           (1<<5)
+#define UART_LSR_TEMT           (1<<6)
+
+extern UART_Type sim_uart_reg[4];   // UART1 ~ 3 은 레지스터만 있고 동작하지 않음
+
+#define UART0                   (&sim_uart_reg[0])
+#define UART1                   (&sim_uart_reg[1])
+#define UART2                   (&sim_uart_reg[2])
+#define UART3                   (&sim_uart_reg[3])
+
+void    UART_Init(UART_Type *UARTn, UART_CFG_Type *UART_ConfigStruct);
+void    UART_SetDivisors(UART_Type *UARTn, uint32_t baudrate);
+
+
+//
+// PCU, NVIC
+//
+typedef struct
+{
+  volatile uint32_t MR;
+} PCU_Type;
+
+#define PCC                     ((PCU_Type *)NULL)
+#define PCD                     ((PCU_Type *)NULL)
+#define PCE                     ((PCU_Type *)NULL)
+#define PIN_6                   6
+#define PIN_7                   7
+#define PIN_8                   8
+#define PIN_9                   9
+#define PIN_10                  10
+#define PIN_11                  11
+#define PIN_12                  12
+#define PIN_13                  13
+#define LOGIC_INPUT             0
+#define PUSHPULL_OUTPUT         1
+#define PC8_MUX_RXD0            1
+#define PC9_MUX_TXD0            1
+#define PD12_MUX_RXD1           1
+#define PD13_MUX_TXD1           1
+#define PC10_MUX_RXD2           1
+#define PC11_MUX_TXD2           1
+#define PE6_MUX_RXD3            1
+#define PE7_MUX_TXD3            1
+#define PULLUP_ENABLE           1
+
+typedef enum
+{
+  UART0_IRQn = 38,
+  UART1_IRQn = 39,
+  UART2_IRQn = 40,
+  UART3_IRQn = 41,
+} IRQn_Type;
+
+#define PCU_SetDirection(pcu, pin, mode)
+#define PCU_ConfigureFunction(pcu, pin, func)
+#define PCU_ConfigurePullupdown(pcu, pin, mode)
+#define NVIC_SetPriority(irq, priority)
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void __disable_irq(void);
+void __enable_irq(void);
+
+
+//
+// FMC
+//
+typedef struct
+{
+  volatile uint32_t TEST;
+  volatile uint32_t PROTECT;
+} FMC_Type;
+
+#define FMTEST_WRITE_KEY        (0x6C93<<16)
+#define FMTEST_EX               (1<<4)
+
+#define FMPROTECT_BP0           (1<<0)
+#define FMPROTECT_BP1           (1<<1)
+#define FMPROTECT_BP2           (1<<2)
+#define FMPROTECT_BP3           (1<<3)
+#define FMPROTECT_BP4           (1<<4)
+#define FMPROTECT_BP5           (1<<5)
+#define FMPROTECT_SP0           (1<<8)
+#define FMPROTECT_SP1           (1<<9)
+#define FMPROTECT_SP2           (1<<10)
+#define FMPROTECT_SP3           (1<<11)
+
+extern FMC_Type *FMC;
+
+int FLASH_Self_EraseSector(FMC_Type * const flash, uint32_t addr);
+int FLASH_Self_ProgramWORD(FMC_Type * const flash, uint32_t addr, uint32_t data);
+int FLASH_EraseSector(FMC_Type * const flash, uint32_t addr);
+int FLASH_ProgramByte(FMC_Type * const flash, uint32_t addr, uint8_t data);
+
+
+extern uint32_t SystemCoreClock;
+
+
+
+bool bspInit(void);
+void bspDeInit(void);
+
+void delay(uint32_t ms);
+uint32_t millis(void);
+
+
+void logPrintf(const char *fmt, ...);
+
+#endif /* TOOLS_BOOTSIM_BSP_H_ */
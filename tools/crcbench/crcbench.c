@@ -0,0 +1,187 @@
+/*
+ * crcbench.c
+ *
+ *  Created on: 2021. 8. 10.
+ *      Author: baram
+ *
+ *  common/core/crc.c 확인 및 속도 비교 툴
+ *
+ *  build : gcc -O2 -D_USE_CRC_BENCH -D_USE_CRC32 -DCRC_SLICE=8
+ *              -I../../a33g526_boot/src/common -I../../a33g526_boot/src/common/core
+ *              crcbench.c ../../a33g526_boot/src/common/core/crc.c
+ *              ../../a33g526_boot/src/common/core/util.c -o crcbench
+ *  usage : crcbench [input.bin]
+ *
+ *  utilUpdateCrc() 와 1/4/8 바이트 방식의 결과가 같은지 확인하고, 펌웨어 영역 크기(224KB) 기준 시간을 비교한다.
+ *  보드에서의 cycle 수는 _USE_CRC_BENCH 로 빌드한 부트로더의 부팅 로그를 참고.
+ */
+
+
+#include <time.h>
+#include "crc.h"
+#include "util.h"
+
+
+#define BENCH_LENGTH      (224*1024)
+#define BENCH_REPEAT      50
+
+
+static uint8_t *p_bench_buf;
+static uint32_t bench_length;
+
+
+static uint16_t crcByUtil(const uint8_t *p_data, uint32_t length)
+{
+  uint16_t crc = 0;
+
+  for (uint32_t i=0; i<length; i++)
+  {
+    utilUpdateCrc(&crc, p_data[i]);
+  }
+  return crc;
+}
+
+static bool checkCrc16(void)
+{
+  uint8_t slice_tbl[3] = {1, 4, 8};
+  uint16_t crc_ref;
+  uint16_t crc;
+
+
+  // 시작 위치와 길이를 바꿔가며 정렬되지 않은 경우까지 확인
+  for (uint32_t offset=0; offset<8; offset++)
+  {
+    for (uint32_t length=0; length<64; length++)
+    {
+      crc_ref = crcByUtil(&p_bench_buf[offset], length);
+
+      for (int i=0; i<3; i++)
+      {
+        crc = 0;
+        crcUpdateSlice(slice_tbl[i], &crc, &p_bench_buf[offset], length);
+        if (crc != crc_ref)
+        {
+          printf("crc16 by%d fail : offset %u, length %u\n", slice_tbl[i], offset, length);
+          return false;
+        }
+      }
+    }
+  }
+
+  // 여러번 나눠서 계산해도 같은지 확인
+  crc_ref = crcByUtil(p_bench_buf, bench_length);
+  for (int i=0; i<3; i++)
+  {
+    uint32_t index = 0;
+
+    crc = 0;
+    while(index < bench_length)
+    {
+      uint32_t chunk;
+
+      chunk = min(bench_length - index, 1 + (index % 1021));
+      crcUpdateSlice(slice_tbl[i], &crc, &p_bench_buf[index], chunk);
+      index += chunk;
+    }
+    if (crc != crc_ref)
+    {
+      printf("crc16 by%d fail : chunk\n", slice_tbl[i]);
+      return false;
+    }
+  }
+
+  crc = 0;
+  crcUpdate(&crc, p_bench_buf, bench_length);
+
+  return (crc == crc_ref) ? true:false;
+}
+
+static bool checkCrc32(void)
+{
+  uint32_t crc;
+
+  // 표준 확인 값 : "123456789" -> 0xCBF43926
+  for (uint32_t offset=0; offset<4; offset++)
+  {
+    uint8_t buf[16];
+
+    memcpy(&buf[offset], "123456789", 9);
+    crc = 0xFFFFFFFF;
+    crc32Update(&crc, &buf[offset], 9);
+    if ((crc ^ 0xFFFFFFFF) != 0xCBF43926)
+    {
+      printf("crc32 fail : offset %u\n", offset);
+      return false;
+    }
+  }
+  return true;
+}
+
+static double benchTime(int slice)
+{
+  clock_t  time_pre;
+  uint16_t crc = 0;
+  volatile uint16_t crc_out;
+
+
+  time_pre = clock();
+  for (int i=0; i<BENCH_REPEAT; i++)
+  {
+    if (slice == 0)
+    {
+      crc = crcByUtil(p_bench_buf, bench_length);
+    }
+    else
+    {
+      crcUpdateSlice(slice, &crc, p_bench_buf, bench_length);
+    }
+  }
+  crc_out = crc;
+  (void)crc_out;
+
+  return (double)(clock() - time_pre) * 1000.0 / CLOCKS_PER_SEC / BENCH_REPEAT;
+}
+
+int main(int argc, char *argv[])
+{
+  FILE *fp;
+
+
+  bench_length = BENCH_LENGTH;
+  p_bench_buf  = malloc(bench_length + 8);
+
+  srand(1);
+  for (uint32_t i=0; i<bench_length + 8; i++)
+  {
+    p_bench_buf[i] = (uint8_t)rand();
+  }
+
+  if (argc == 2)
+  {
+    fp = fopen(argv[1], "rb");
+    if (fp == NULL)
+    {
+      printf("read fail : %s\n", argv[1]);
+      return 1;
+    }
+    bench_length = (uint32_t)fread(p_bench_buf, 1, BENCH_LENGTH, fp);
+    fclose(fp);
+  }
+
+  crcInit();
+
+  if (checkCrc16() != true || checkCrc32() != true)
+  {
+    printf("verify fail\n");
+    return 1;
+  }
+  printf("verify OK (CRC_SLICE %d)\n", CRC_SLICE);
+
+  printf("%u bytes, ms per pass\n", bench_length);
+  printf("  utilUpdateCrc : %8.3f\n", benchTime(0));
+  printf("  crc by1       : %8.3f\n", benchTime(1));
+  printf("  crc by4       : %8.3f\n", benchTime(4));
+  printf("  crc by8       : %8.3f\n", benchTime(8));
+
+  return 0;
+}
@@ -0,0 +1,342 @@
+/*
+ * deltagen.c
+ *
+ *  Created on: 2021. 8. 9.
+ *      Author: baram
+ *
+ *  BOOT_CMD_DELTA_BEGIN/WRITE/END 용 패치 생성 툴 (포맷은 common/core/delta.h 참고)
+ *
+ *  build : gcc -O2 -I../../a33g526_boot/src/common -I../../a33g526_boot/src/common/core
+ *              deltagen.c ../../a33g526_boot/src/common/core/delta.c
+ *              ../../a33g526_boot/src/common/core/util.c -o deltagen
+ *  usage : deltagen old.bin new.bin output.dlt
+ *
+ *  보드는 섹터 순서대로 덮어쓰므로, Copy 는 아직 덮어쓰지 않은 이전 이미지만 참조하도록 만든다.
+ *  생성 후에는 보드와 같은 delta.c 로 섹터 단위 덮어쓰기를 흉내내어 새 이미지와 같은지 확인한다.
+ */
+
+
+#include "delta.h"
+#include "util.h"
+
+
+#define SECTOR_LENGTH     1024
+#define COPY_MIN          8
+#define HASH_BITS         16
+#define HASH_SIZE         (1<<HASH_BITS)
+#define HASH_LENGTH       4
+#define CHAIN_MAX         256
+
+
+typedef struct
+{
+  uint8_t  *p_buf;
+  uint32_t  len;
+  uint32_t  size;
+} buf_t;
+
+
+static int32_t hash_head[HASH_SIZE];
+static int32_t *hash_prev;
+
+static uint8_t  *sim_flash;
+static uint32_t  sim_old_len;
+static uint32_t  sim_new_len;
+static uint32_t  sim_stage_addr;
+static uint32_t  sim_out_len;
+static uint8_t   sim_stage[SECTOR_LENGTH];
+static uint32_t  sim_stage_len;
+
+
+static bool bufPut(buf_t *p_buf, uint8_t data)
+{
+  if (p_buf->len >= p_buf->size)
+  {
+    p_buf->size  = p_buf->size ? p_buf->size * 2 : 4096;
+    p_buf->p_buf = realloc(p_buf->p_buf, p_buf->size);
+    if (p_buf->p_buf == NULL)
+    {
+      return false;
+    }
+  }
+  p_buf->p_buf[p_buf->len++] = data;
+  return true;
+}
+
+static uint32_t hashGet(uint8_t *p)
+{
+  return ((uint32_t)(p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]) * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static uint32_t sectorStart(uint32_t offset)
+{
+  return offset - (offset % SECTOR_LENGTH);
+}
+
+// new[pos] 부터 old[src] 와 같은 길이, 덮어쓴 영역은 참조하지 않는다.
+//
+static uint32_t matchLength(uint8_t *p_old, uint32_t old_len, uint8_t *p_new, uint32_t new_len,
+                            uint32_t src, uint32_t pos)
+{
+  uint32_t len = 0;
+
+  while(pos + len < new_len &&
+        src + len < old_len &&
+        len < DELTA_COPY_MAX &&
+        src + len >= sectorStart(pos + len) &&
+        p_old[src + len] == p_new[pos + len])
+  {
+    len++;
+  }
+
+  return len;
+}
+
+static void flushInsert(buf_t *p_out, uint8_t *p_new, uint32_t begin, uint32_t end)
+{
+  while(begin < end)
+  {
+    uint32_t count;
+
+    count = min(end - begin, DELTA_INSERT_MAX);
+
+    bufPut(p_out, (uint8_t)(count - 1));
+    for (int i=0; i<count; i++)
+    {
+      bufPut(p_out, p_new[begin + i]);
+    }
+    begin += count;
+  }
+}
+
+static void generate(uint8_t *p_old, uint32_t old_len, uint8_t *p_new, uint32_t new_len, buf_t *p_out)
+{
+  uint32_t pos = 0;
+  uint32_t ins_begin = 0;
+
+
+  hash_prev = malloc(sizeof(int32_t) * (old_len + 1));
+
+  for (int i=0; i<HASH_SIZE; i++)
+  {
+    hash_head[i] = -1;
+  }
+  for (uint32_t i=0; i + HASH_LENGTH <= old_len; i++)
+  {
+    uint32_t h = hashGet(&p_old[i]);
+    hash_prev[i] = hash_head[h];
+    hash_head[h] = i;
+  }
+
+  while(pos < new_len)
+  {
+    uint32_t best_len = 0;
+    uint32_t best_src = 0;
+
+    // 같은 위치를 먼저 확인 (변경되지 않은 영역)
+    if (pos < old_len)
+    {
+      best_len = matchLength(p_old, old_len, p_new, new_len, pos, pos);
+      best_src = pos;
+    }
+
+    if (best_len < DELTA_COPY_MAX && pos + HASH_LENGTH <= new_len)
+    {
+      int32_t cand = hash_head[hashGet(&p_new[pos])];
+      int     chain = 0;
+
+      while(cand >= 0 && chain++ < CHAIN_MAX)
+      {
+        uint32_t len;
+
+        len = matchLength(p_old, old_len, p_new, new_len, (uint32_t)cand, pos);
+        if (len > best_len)
+        {
+          best_len = len;
+          best_src = (uint32_t)cand;
+        }
+        cand = hash_prev[cand];
+      }
+    }
+
+    if (best_len >= COPY_MIN)
+    {
+      flushInsert(p_out, p_new, ins_begin, pos);
+
+      bufPut(p_out, DELTA_TOKEN_COPY);
+      bufPut(p_out, (uint8_t)(best_src >>  0));
+      bufPut(p_out, (uint8_t)(best_src >>  8));
+      bufPut(p_out, (uint8_t)(best_src >> 16));
+      bufPut(p_out, (uint8_t)(best_len >>  0));
+      bufPut(p_out, (uint8_t)(best_len >>  8));
+
+      pos += best_len;
+      ins_begin = pos;
+    }
+    else
+    {
+      pos++;
+    }
+  }
+  flushInsert(p_out, p_new, ins_begin, pos);
+
+  free(hash_prev);
+}
+
+static void simStage(void)
+{
+  memcpy(&sim_flash[sim_stage_addr], sim_stage, sim_stage_len);
+  sim_stage_addr += sim_stage_len;
+  sim_stage_len = 0;
+}
+
+static bool simRead(uint32_t offset, uint8_t *p_data)
+{
+  if (offset >= sim_old_len || offset < sim_stage_addr)
+  {
+    return false;
+  }
+  *p_data = sim_flash[offset];
+  return true;
+}
+
+static bool simWrite(uint8_t data)
+{
+  if (sim_out_len >= sim_new_len)
+  {
+    return false;
+  }
+  sim_out_len++;
+
+  sim_stage[sim_stage_len++] = data;
+  if (sim_stage_len >= SECTOR_LENGTH)
+  {
+    simStage();
+  }
+  return true;
+}
+
+static bool verify(uint8_t *p_old, uint32_t old_len, uint8_t *p_new, uint32_t new_len, buf_t *p_delta)
+{
+  delta_t delta;
+  uint32_t index = 0;
+
+
+  sim_flash = calloc(max(old_len, new_len) + 1, 1);
+  memcpy(sim_flash, p_old, old_len);
+  sim_old_len    = old_len;
+  sim_new_len    = new_len;
+  sim_stage_addr = 0;
+  sim_stage_len  = 0;
+  sim_out_len    = 0;
+
+  deltaCreate(&delta, simRead, simWrite);
+
+  // 보드와 같이 패킷 크기 단위로 나눠서 적용해 본다.
+  while(index < p_delta->len)
+  {
+    uint32_t chunk;
+
+    chunk = min(p_delta->len - index, 1016);
+    if (deltaDecode(&delta, &p_delta->p_buf[index], chunk) != true)
+    {
+      return false;
+    }
+    index += chunk;
+  }
+  simStage();
+
+  return (deltaIsDone(&delta) == true &&
+          sim_out_len == new_len &&
+          memcmp(sim_flash, p_new, new_len) == 0) ? true:false;
+}
+
+static uint8_t *readFile(const char *name, uint32_t *p_length)
+{
+  FILE *fp;
+  long  size;
+  uint8_t *p_buf;
+
+  fp = fopen(name, "rb");
+  if (fp == NULL)
+  {
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+
+  p_buf = malloc(size > 0 ? size : 1);
+  if (fread(p_buf, 1, size, fp) != (size_t)size)
+  {
+    free(p_buf);
+    p_buf = NULL;
+  }
+  fclose(fp);
+
+  *p_length = (uint32_t)size;
+  return p_buf;
+}
+
+int main(int argc, char *argv[])
+{
+  uint8_t *p_old;
+  uint8_t *p_new;
+  uint32_t old_len;
+  uint32_t new_len;
+  buf_t    out = {NULL, 0, 0};
+  delta_file_header_t header;
+  FILE    *fp;
+
+
+  if (argc != 4)
+  {
+    printf("deltagen old.bin new.bin output.dlt\n");
+    return 1;
+  }
+
+  p_old = readFile(argv[1], &old_len);
+  p_new = readFile(argv[2], &new_len);
+  if (p_old == NULL || p_new == NULL)
+  {
+    printf("read fail\n");
+    return 1;
+  }
+  if (old_len == 0 || new_len == 0 || old_len > DELTA_OFFSET_MAX)
+  {
+    printf("wrong length : %u, %u\n", old_len, new_len);
+    return 1;
+  }
+
+  generate(p_old, old_len, p_new, new_len, &out);
+
+  if (verify(p_old, old_len, p_new, new_len, &out) != true)
+  {
+    printf("verify fail\n");
+    return 1;
+  }
+
+  header.magic      = DELTA_FILE_MAGIC;
+  header.old_length = old_len;
+  header.new_length = new_len;
+  header.old_crc    = 0;
+  header.reserved   = 0;
+  for (uint32_t i=0; i<old_len; i++)
+  {
+    utilUpdateCrc(&header.old_crc, p_old[i]);
+  }
+
+  fp = fopen(argv[3], "wb");
+  if (fp == NULL ||
+      fwrite(&header, 1, sizeof(header), fp) != sizeof(header) ||
+      fwrite(out.p_buf, 1, out.len, fp) != out.len)
+  {
+    printf("write fail : %s\n", argv[3]);
+    return 1;
+  }
+  fclose(fp);
+
+  printf("%s -> %s : %u bytes patch (%u%% of new), verify OK\n", argv[1], argv[2], out.len, new_len ? out.len * 100 / new_len : 0);
+
+  return 0;
+}
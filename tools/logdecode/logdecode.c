@@ -0,0 +1,242 @@
+/*
+ * logdecode.c
+ *
+ *  Created on: 2021. 8. 15.
+ *      Author: baram
+ *
+ *  logDeferBinary(true) 로 출력된 로그를 텍스트로 바꾸는 툴
+ *
+ *  build : gcc -O2 logdecode.c -o logdecode
+ *  usage : logdecode firmware.elf [capture.bin]     (capture 파일이 없으면 stdin)
+ *
+ *  - 포맷 문자열은 ELF 의 log_str 섹션에서 찾는다. (ID = 섹션 시작부터의 offset)
+ *  - 프레임 : 0xA5, argc, ID(16bit LE), 인자(32bit LE x argc)
+ *  - 프레임이 아닌 바이트는 logPrintf() 로 나온 텍스트이므로 그대로 출력한다.
+ */
+
+
+#include <elf.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define FRAME_STX         0xA5
+#define FRAME_ARG_MAX     6
+#define LOG_STR_NAME      "log_str"
+
+
+static char     *log_str;
+static uint32_t  log_str_len;
+
+
+static uint8_t *fileRead(const char *name, uint32_t *p_len)
+{
+  FILE    *fp;
+  uint8_t *p_buf;
+  long     len;
+
+
+  fp = fopen(name, "rb");
+  if (fp == NULL)
+  {
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  len = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+
+  p_buf = malloc(len + 1);
+  if (fread(p_buf, 1, len, fp) != (size_t)len)
+  {
+    free(p_buf);
+    p_buf = NULL;
+  }
+  fclose(fp);
+
+  *p_len = (uint32_t)len;
+  return p_buf;
+}
+
+// ELF32(보드), ELF64(호스트 테스트) 모두 섹션 헤더에서 이름으로 찾는다.
+//
+static bool elfLoadLogStr(uint8_t *p_elf, uint32_t elf_len)
+{
+  uint64_t sh_off;
+  uint32_t sh_num;
+  uint32_t sh_size;
+  uint32_t sh_strndx;
+  bool     is_64;
+
+
+  if (elf_len < EI_NIDENT || memcmp(p_elf, ELFMAG, SELFMAG) != 0)
+  {
+    return false;
+  }
+  is_64 = (p_elf[EI_CLASS] == ELFCLASS64) ? true:false;
+
+  if (is_64 == true)
+  {
+    Elf64_Ehdr *p_hdr = (Elf64_Ehdr *)p_elf;
+
+    sh_off    = p_hdr->e_shoff;
+    sh_num    = p_hdr->e_shnum;
+    sh_size   = p_hdr->e_shentsize;
+    sh_strndx = p_hdr->e_shstrndx;
+  }
+  else
+  {
+    Elf32_Ehdr *p_hdr = (Elf32_Ehdr *)p_elf;
+
+    sh_off    = p_hdr->e_shoff;
+    sh_num    = p_hdr->e_shnum;
+    sh_size   = p_hdr->e_shentsize;
+    sh_strndx = p_hdr->e_shstrndx;
+  }
+  if (sh_off + (uint64_t)sh_num * sh_size > elf_len || sh_strndx >= sh_num)
+  {
+    return false;
+  }
+
+  for (uint32_t i=0; i<sh_num; i++)
+  {
+    uint64_t name_off;
+    uint64_t str_off;
+    uint64_t off;
+    uint64_t len;
+    uint8_t *p_sh     = &p_elf[sh_off + (uint64_t)i * sh_size];
+    uint8_t *p_sh_str = &p_elf[sh_off + (uint64_t)sh_strndx * sh_size];
+
+    if (is_64 == true)
+    {
+      name_off = ((Elf64_Shdr *)p_sh)->sh_name;
+      str_off  = ((Elf64_Shdr *)p_sh_str)->sh_offset;
+      off      = ((Elf64_Shdr *)p_sh)->sh_offset;
+      len      = ((Elf64_Shdr *)p_sh)->sh_size;
+    }
+    else
+    {
+      name_off = ((Elf32_Shdr *)p_sh)->sh_name;
+      str_off  = ((Elf32_Shdr *)p_sh_str)->sh_offset;
+      off      = ((Elf32_Shdr *)p_sh)->sh_offset;
+      len      = ((Elf32_Shdr *)p_sh)->sh_size;
+    }
+
+    if (str_off + name_off >= elf_len || off + len > elf_len)
+    {
+      continue;
+    }
+    if (strcmp((char *)&p_elf[str_off + name_off], LOG_STR_NAME) == 0)
+    {
+      log_str     = (char *)&p_elf[off];
+      log_str_len = (uint32_t)len;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void frameDecode(uint8_t *p_frame)
+{
+  uint32_t argc;
+  uint32_t id;
+  uint32_t args[FRAME_ARG_MAX] = {0, };
+
+
+  argc = p_frame[1];
+  id   = p_frame[2] | (p_frame[3] << 8);
+
+  for (uint32_t i=0; i<argc; i++)
+  {
+    uint8_t *p_arg = &p_frame[4 + i*4];
+
+    args[i] = p_arg[0] | (p_arg[1] << 8) | (p_arg[2] << 16) | ((uint32_t)p_arg[3] << 24);
+  }
+
+  if (id >= log_str_len || memchr(&log_str[id], 0, log_str_len - id) == NULL)
+  {
+    printf("[logdecode] unknown id 0x%04X\n", id);
+    return;
+  }
+
+  // 보드와 같이 인자는 모두 32비트 정수
+  //
+  printf(&log_str[id], args[0], args[1], args[2], args[3], args[4], args[5]);
+}
+
+int main(int argc, char *argv[])
+{
+  uint8_t *p_elf;
+  uint32_t elf_len;
+  FILE    *fp = stdin;
+  uint8_t  frame[4 + FRAME_ARG_MAX * 4];
+  uint32_t frame_len = 0;
+  int      ch;
+
+
+  if (argc < 2)
+  {
+    printf("logdecode firmware.elf [capture.bin]\n");
+    return 1;
+  }
+
+  p_elf = fileRead(argv[1], &elf_len);
+  if (p_elf == NULL || elfLoadLogStr(p_elf, elf_len) != true)
+  {
+    printf("%s : no %s section\n", argv[1], LOG_STR_NAME);
+    return 1;
+  }
+
+  if (argc >= 3)
+  {
+    fp = fopen(argv[2], "rb");
+    if (fp == NULL)
+    {
+      printf("%s : open fail\n", argv[2]);
+      return 1;
+    }
+  }
+
+  while((ch = fgetc(fp)) != EOF)
+  {
+    if (frame_len == 0)
+    {
+      if (ch == FRAME_STX)
+      {
+        frame[frame_len++] = ch;
+      }
+      else
+      {
+        putchar(ch);
+      }
+      continue;
+    }
+
+    // argc 가 범위를 벗어나면 프레임이 아니므로 텍스트로 출력
+    //
+    if (frame_len == 1 && ch > FRAME_ARG_MAX)
+    {
+      putchar(FRAME_STX);
+      putchar(ch);
+      frame_len = 0;
+      continue;
+    }
+
+    frame[frame_len++] = ch;
+    if (frame_len == 4 + frame[1] * 4)
+    {
+      frameDecode(frame);
+      frame_len = 0;
+    }
+  }
+
+  if (fp != stdin)
+  {
+    fclose(fp);
+  }
+
+  return 0;
+}
@@ -0,0 +1,266 @@
+/*
+ * lzpack.c
+ *
+ *  Created on: 2021. 8. 8.
+ *      Author: baram
+ *
+ *  BOOT_CMD_FLASH_WRITE_COMPRESSED 용 압축 툴 (포맷은 common/core/lz.h 참고)
+ *
+ *  build : gcc -O2 -I../../a33g526_boot/src/common -I../../a33g526_boot/src/common/core
+ *              lzpack.c ../../a33g526_boot/src/common/core/lz.c -o lzpack
+ *  usage : lzpack input.bin output.lz
+ *
+ *  압축 후에는 보드와 같은 lz.c 로 다시 풀어서 원본과 같은지 확인한다.
+ */
+
+
+#include "lz.h"
+
+
+#define HASH_BITS         15
+#define HASH_SIZE         (1<<HASH_BITS)
+#define CHAIN_MAX         256
+
+
+typedef struct
+{
+  uint8_t  *p_buf;
+  uint32_t  len;
+  uint32_t  size;
+} buf_t;
+
+
+static int32_t hash_head[HASH_SIZE];
+static int32_t *hash_prev;
+
+static buf_t   verify_buf;
+static uint8_t *verify_ref;
+static uint32_t verify_ref_len;
+
+
+static bool bufPut(buf_t *p_buf, uint8_t data)
+{
+  if (p_buf->len >= p_buf->size)
+  {
+    p_buf->size  = p_buf->size ? p_buf->size * 2 : 4096;
+    p_buf->p_buf = realloc(p_buf->p_buf, p_buf->size);
+    if (p_buf->p_buf == NULL)
+    {
+      return false;
+    }
+  }
+  p_buf->p_buf[p_buf->len++] = data;
+  return true;
+}
+
+static uint32_t hashGet(uint8_t *p)
+{
+  return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static void flushLiteral(buf_t *p_out, uint8_t *p_src, uint32_t begin, uint32_t end)
+{
+  while(begin < end)
+  {
+    uint32_t count;
+
+    count = min(end - begin, LZ_LITERAL_MAX);
+
+    bufPut(p_out, (uint8_t)(count - 1));
+    for (int i=0; i<count; i++)
+    {
+      bufPut(p_out, p_src[begin + i]);
+    }
+    begin += count;
+  }
+}
+
+static void compress(uint8_t *p_src, uint32_t length, buf_t *p_out)
+{
+  uint32_t pos = 0;
+  uint32_t lit_begin = 0;
+
+
+  hash_prev = malloc(sizeof(int32_t) * (length + 1));
+
+  for (int i=0; i<HASH_SIZE; i++)
+  {
+    hash_head[i] = -1;
+  }
+
+  while(pos < length)
+  {
+    uint32_t best_len = 0;
+    uint32_t best_off = 0;
+
+    if (pos + LZ_MATCH_MIN <= length)
+    {
+      uint32_t h = hashGet(&p_src[pos]);
+      int32_t  cand = hash_head[h];
+      int      chain = 0;
+
+      while(cand >= 0 && pos - cand <= LZ_OFFSET_MAX && chain++ < CHAIN_MAX)
+      {
+        uint32_t len = 0;
+        uint32_t len_max = min(length - pos, LZ_MATCH_MAX);
+
+        // 겹치는 복사도 허용 (offset < length)
+        while(len < len_max && p_src[cand + len] == p_src[pos + len])
+        {
+          len++;
+        }
+        if (len > best_len)
+        {
+          best_len = len;
+          best_off = pos - cand;
+          if (len == len_max) break;
+        }
+        cand = hash_prev[cand];
+      }
+    }
+
+    if (best_len >= LZ_MATCH_MIN)
+    {
+      flushLiteral(p_out, p_src, lit_begin, pos);
+
+      bufPut(p_out, (uint8_t)(LZ_TOKEN_MATCH | (best_len - LZ_MATCH_MIN)));
+      bufPut(p_out, (uint8_t)(best_off >> 0));
+      bufPut(p_out, (uint8_t)(best_off >> 8));
+
+      for (int i=0; i<best_len; i++)
+      {
+        if (pos + LZ_MATCH_MIN <= length)
+        {
+          uint32_t h = hashGet(&p_src[pos]);
+          hash_prev[pos] = hash_head[h];
+          hash_head[h] = pos;
+        }
+        pos++;
+      }
+      lit_begin = pos;
+    }
+    else
+    {
+      if (pos + LZ_MATCH_MIN <= length)
+      {
+        uint32_t h = hashGet(&p_src[pos]);
+        hash_prev[pos] = hash_head[h];
+        hash_head[h] = pos;
+      }
+      pos++;
+    }
+  }
+  flushLiteral(p_out, p_src, lit_begin, pos);
+
+  free(hash_prev);
+}
+
+static uint8_t verifyRead(uint32_t index)
+{
+  return verify_buf.p_buf[index];
+}
+
+static bool verifyWrite(uint8_t data)
+{
+  if (verify_buf.len >= verify_ref_len || verify_ref[verify_buf.len] != data)
+  {
+    return false;
+  }
+  return bufPut(&verify_buf, data);
+}
+
+static bool verify(uint8_t *p_src, uint32_t length, buf_t *p_lz_data)
+{
+  lz_t lz;
+  uint32_t index = 0;
+
+
+  verify_ref     = p_src;
+  verify_ref_len = length;
+
+  lzCreate(&lz, verifyRead, verifyWrite);
+
+  // 보드와 같이 패킷 크기 단위로 나눠서 풀어본다.
+  while(index < p_lz_data->len)
+  {
+    uint32_t chunk;
+
+    chunk = min(p_lz_data->len - index, 1016);
+    if (lzDecode(&lz, &p_lz_data->p_buf[index], chunk) != true)
+    {
+      return false;
+    }
+    index += chunk;
+  }
+
+  return (lzIsDone(&lz) == true && verify_buf.len == length) ? true:false;
+}
+
+static uint8_t *readFile(const char *name, uint32_t *p_length)
+{
+  FILE *fp;
+  long  size;
+  uint8_t *p_buf;
+
+  fp = fopen(name, "rb");
+  if (fp == NULL)
+  {
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+
+  p_buf = malloc(size > 0 ? size : 1);
+  if (fread(p_buf, 1, size, fp) != (size_t)size)
+  {
+    free(p_buf);
+    p_buf = NULL;
+  }
+  fclose(fp);
+
+  *p_length = (uint32_t)size;
+  return p_buf;
+}
+
+int main(int argc, char *argv[])
+{
+  uint8_t *p_src;
+  uint32_t length;
+  buf_t    out = {NULL, 0, 0};
+  FILE    *fp;
+
+
+  if (argc != 3)
+  {
+    printf("lzpack input.bin output.lz\n");
+    return 1;
+  }
+
+  p_src = readFile(argv[1], &length);
+  if (p_src == NULL)
+  {
+    printf("read fail : %s\n", argv[1]);
+    return 1;
+  }
+
+  compress(p_src, length, &out);
+
+  if (verify(p_src, length, &out) != true)
+  {
+    printf("verify fail\n");
+    return 1;
+  }
+
+  fp = fopen(argv[2], "wb");
+  if (fp == NULL || fwrite(out.p_buf, 1, out.len, fp) != out.len)
+  {
+    printf("write fail : %s\n", argv[2]);
+    return 1;
+  }
+  fclose(fp);
+
+  printf("%s : %u -> %u bytes (%u%%), verify OK\n", argv[1], length, out.len, length ? out.len * 100 / length : 0);
+
+  return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * qbufbench.c
+ *
+ *  Created on: 2021. 8. 14.
+ *      Author: baram
+ *
+ *  common/core/qbuffer.c 확인 및 속도 비교 툴
+ *
+ *  build : gcc -O2 -pthread -I../../a33g526_boot/src/common -I../../a33g526_boot/src/common/core
+ *              qbufbench.c ../../a33g526_boot/src/common/core/qbuffer.c -o qbufbench
+ *  usage : qbufbench [MB]
+ *
+ *  - stress : 2의 거듭제곱 길이(SPSC 모드)에서 쓰는 쓰레드/읽는 쓰레드를 따로 돌려서 (span API 포함)
+ *             순서대로 빠짐없이 전달되는지 확인 (원소 크기 1, 4, 12)
+ *  - bench  : 이전 방식(길이 1000)과 SPSC 모드(길이 1024)의 1개씩/16개씩 쓰고 읽는 시간 비교
+ */
+
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "qbuffer.h"
+
+
+#define STRESS_BUF_LENGTH     256
+#define BENCH_CHUNK           16
+
+
+typedef struct
+{
+  qbuffer_t  qbuffer;
+  uint32_t   size;
+  uint64_t   count;
+  volatile bool is_fail;
+} stress_t;
+
+
+static uint32_t randGet(uint32_t *p_seed)
+{
+  *p_seed = *p_seed * 1103515245 + 12345;
+  return *p_seed >> 16;
+}
+
+static void elementSet(uint8_t *p_data, uint32_t size, uint64_t index)
+{
+  for (uint32_t i=0; i<size; i++)
+  {
+    p_data[i] = (uint8_t)(index * 7 + i);
+  }
+}
+
+static bool elementCheck(uint8_t *p_data, uint32_t size, uint64_t index)
+{
+  for (uint32_t i=0; i<size; i++)
+  {
+    if (p_data[i] != (uint8_t)(index * 7 + i))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void *stressProducer(void *arg)
+{
+  stress_t *p_stress = (stress_t *)arg;
+  uint8_t   buf[BENCH_CHUNK * 16];
+  uint64_t  index = 0;
+  uint32_t  seed = 1;
+
+
+  while(index < p_stress->count && p_stress->is_fail != true)
+  {
+    uint32_t length;
+    uint32_t avail;
+
+    length = 1 + randGet(&seed) % BENCH_CHUNK;
+    length = (uint32_t)min((uint64_t)length, p_stress->count - index);
+
+    // 빈 공간만큼만 쓴다.
+    avail = p_stress->qbuffer.len - qbufferAvailable(&p_stress->qbuffer);
+    length = min(length, avail);
+    if (length == 0)
+    {
+      sched_yield();
+      continue;
+    }
+
+    // qbufferGetWriteSpan()/qbufferProduce() 와 qbufferWrite() 를 섞어서 사용
+    if (length % 3 == 0)
+    {
+      uint8_t *p_span;
+
+      length = min(length, qbufferGetWriteSpan(&p_stress->qbuffer, &p_span));
+      for (uint32_t i=0; i<length; i++)
+      {
+        elementSet(&p_span[i * p_stress->size], p_stress->size, index + i);
+      }
+      qbufferProduce(&p_stress->qbuffer, length);
+      index += length;
+      continue;
+    }
+
+    for (uint32_t i=0; i<length; i++)
+    {
+      elementSet(&buf[i * p_stress->size], p_stress->size, index + i);
+    }
+    if (qbufferWrite(&p_stress->qbuffer, buf, length) != true)
+    {
+      printf("  write fail : %llu\n", (unsigned long long)index);
+      p_stress->is_fail = true;
+    }
+    index += length;
+  }
+
+  return NULL;
+}
+
+static void *stressConsumer(void *arg)
+{
+  stress_t *p_stress = (stress_t *)arg;
+  uint8_t   buf[BENCH_CHUNK * 16];
+  uint64_t  index = 0;
+  uint32_t  seed = 2;
+
+
+  while(index < p_stress->count && p_stress->is_fail != true)
+  {
+    uint32_t length;
+
+    // qbufferRead(), qbufferReadBulk(), qbufferGetReadSpan()/qbufferConsume() 를 섞어서 사용
+    length = 1 + randGet(&seed) % BENCH_CHUNK;
+    if (length % 3 == 0)
+    {
+      uint8_t *p_span;
+
+      length = min(length, qbufferGetReadSpan(&p_stress->qbuffer, &p_span));
+      memcpy(buf, p_span, length * p_stress->size);
+      qbufferConsume(&p_stress->qbuffer, length);
+    }
+    else if (length & 1)
+    {
+      length = qbufferReadBulk(&p_stress->qbuffer, buf, length);
+    }
+    else if (qbufferAvailable(&p_stress->qbuffer) == 0)
+    {
+      sched_yield();
+      continue;
+    }
+    else
+    {
+      length = min(length, qbufferAvailable(&p_stress->qbuffer));
+      if (length > 0 && qbufferRead(&p_stress->qbuffer, buf, length) != true)
+      {
+        printf("  read fail : %llu\n", (unsigned long long)index);
+        p_stress->is_fail = true;
+      }
+    }
+
+    for (uint32_t i=0; i<length; i++)
+    {
+      if (elementCheck(&buf[i * p_stress->size], p_stress->size, index + i) != true)
+      {
+        printf("  data fail : %llu\n", (unsigned long long)(index + i));
+        p_stress->is_fail = true;
+        break;
+      }
+    }
+    index += length;
+  }
+
+  return NULL;
+}
+
+static bool stressTest(uint32_t size, uint64_t count)
+{
+  static uint8_t buf[STRESS_BUF_LENGTH * 16];
+  stress_t  stress;
+  pthread_t producer;
+  pthread_t consumer;
+  clock_t   time_pre;
+
+
+  qbufferCreateBySize(&stress.qbuffer, buf, size, STRESS_BUF_LENGTH);
+  stress.size    = size;
+  stress.count   = count;
+  stress.is_fail = false;
+
+  time_pre = clock();
+  pthread_create(&producer, NULL, stressProducer, &stress);
+  pthread_create(&consumer, NULL, stressConsumer, &stress);
+  pthread_join(producer, NULL);
+  pthread_join(consumer, NULL);
+
+  printf("  size %2u : %llu elements, %s (%.0f ms cpu)\n",
+         size,
+         (unsigned long long)count,
+         stress.is_fail ? "FAIL":"OK",
+         (double)(clock() - time_pre) * 1000.0 / CLOCKS_PER_SEC);
+
+  return (stress.is_fail != true) ? true:false;
+}
+
+static double benchTime(uint32_t length, uint32_t chunk, uint64_t total)
+{
+  static uint8_t buf[1024];
+  uint8_t    data[BENCH_CHUNK];
+  qbuffer_t  qbuffer;
+  clock_t    time_pre;
+  volatile uint8_t sum = 0;
+
+
+  qbufferCreate(&qbuffer, buf, length);
+  memset(data, 0x5A, sizeof(data));
+
+  time_pre = clock();
+  for (uint64_t i=0; i<total; i+=chunk)
+  {
+    qbufferWrite(&qbuffer, data, chunk);
+    if (qbufferAvailable(&qbuffer) >= chunk)
+    {
+      qbufferRead(&qbuffer, data, chunk);
+      sum += data[0];
+    }
+  }
+
+  return (double)(clock() - time_pre) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+  uint64_t total = 64;
+  bool     ret = true;
+
+
+  if (argc == 2)
+  {
+    total = strtoul(argv[1], NULL, 0);
+  }
+  total *= 1024 * 1024;
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+
+  printf("stress (SPSC, length %u)\n", STRESS_BUF_LENGTH);
+  ret &= stressTest(1,  total);
+  ret &= stressTest(4,  total / 4);
+  ret &= stressTest(12, total / 12);
+
+  if (ret != true)
+  {
+    printf("verify fail\n");
+    return 1;
+  }
+
+  printf("bench %lluMB, ms\n", (unsigned long long)(total / (1024 * 1024)));
+  printf("                    by1      by%d\n", BENCH_CHUNK);
+  printf("  mod  (1000) : %8.1f %8.1f\n", benchTime(1000, 1, total), benchTime(1000, BENCH_CHUNK, total));
+  printf("  mask (1024) : %8.1f %8.1f\n", benchTime(1024, 1, total), benchTime(1024, BENCH_CHUNK, total));
+
+  return 0;
+}
@@ -0,0 +1,1513 @@
+/*
+ * uploader.cpp
+ *
+ *  Created on: 2021. 8. 12.
+ *      Author: baram
+ *
+ *  부트로더 cmd 프로토콜 펌웨어 업로드 툴
+ *
+ *  build : g++ -O2 -std=c++17 -I../../a33g526_boot/src/common -I../../a33g526_boot/src/common/core
+ *              uploader.cpp ../../a33g526_boot/src/common/core/crc.c -o uploader
+ *  usage : uploader -p /dev/ttyUSB0 [-b 921600] [-w window] [-a 0x8000] [-f] [-n] [-z] [-d old.bin] firmware.bin
+ *          uploader -p /dev/ttyUSB0 [-b 921600] [-a 0x8000] -r length dump.bin
+ *
+ *          -p : 시리얼 포트 (pty 도 가능)
+ *          -b : 업로드 중 사용할 속도 (SET_BAUD, 실패하면 115200 유지)
+ *          -w : 요청할 Window 크기 (0 이면 패킷마다 응답 대기, 기본은 부트로더가 허용하는 최대)
+ *          -a : firmware.bin 의 시작 주소 (태그 섹터)
+ *          -f : 섹터 CRC 를 비교하지 않고 전체 Write
+ *          -n : 업로드 후 펌웨어로 점프하지 않음
+ *          -r : 업로드 대신 -a 주소부터 length 바이트를 FLASH_READ 로 읽어서 파일로 저장
+ *               (부트로더 영역/FLASH_ADDR_BOOT_INFO 섹터를 포함한 Flash 전체와 RAM 0x20000000~ 24KB 를 읽을 수 있음)
+ *          -z : 바뀐 섹터를 lz 로 압축해서 FLASH_WRITE_COMPRESSED 로 보냄 (포맷은 lz.h, 인코더는 tools/lzpack 과 같음)
+ *          -d : 설치된 이미지가 old.bin 이면 DELTA_BEGIN/WRITE/END 로 패치만 보냄 (포맷은 delta.h, 인코더는 tools/deltagen 과 같음)
+ *               설치된 이미지가 다르거나 이전 패치가 중간에 끊겼으면 일반 업로드로 진행
+ *
+ *  firmware.bin 은 태그 섹터부터 시작하는 이미지로, 태그의 CRC/길이를 채워서 보낸다.
+ *  태그 섹터는 마지막에 Write 하여 중간에 끊겨도 부트로더가 펌웨어로 점프하지 않도록 한다.
+ *  업로드 후 부트로더의 수신 Drop/Overrun 카운트가 0 이 아니면 경고를 출력한다.
+ */
+
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+#include "def.h"
+#include "crc.h"
+#include "lz.h"
+#include "delta.h"
+
+
+#define CMD_STX                         0x02
+#define CMD_ETX                         0x03
+#define CMD_STX_SEQ                     0x04
+
+#define CMD_DIR_M_TO_S                  0
+#define CMD_OK                          0
+
+#define BOOT_CMD_READ_BOOT_VERSION      0x00
+#define BOOT_CMD_READ_BOOT_NAME         0x01
+#define BOOT_CMD_FLASH_ERASE            0x04
+#define BOOT_CMD_FLASH_WRITE            0x05
+#define BOOT_CMD_JUMP_TO_FW             0x08
+#define BOOT_CMD_READ_CAPS              0x09
+#define BOOT_CMD_FLASH_WRITE_COMPRESSED 0x0A
+#define BOOT_CMD_DELTA_BEGIN            0x0B
+#define BOOT_CMD_DELTA_WRITE            0x0C
+#define BOOT_CMD_DELTA_END              0x0D
+#define BOOT_CMD_FLASH_READ_CRC         0x0E
+#define BOOT_CMD_SET_BAUD               0x0F
+#define BOOT_CMD_FLASH_READ             0x11
+#define BOOT_CMD_READ_UART_STAT         0x12
+
+#define BOOT_ERR_WRONG_SEQ              0x09
+#define BOOT_ERR_DELTA_BASE             0x0B
+
+#define BOOT_CAPS_WINDOW                (1<<1)
+#define BOOT_CAPS_COMPRESS              (1<<2)
+#define BOOT_CAPS_DELTA                 (1<<3)
+#define BOOT_CAPS_SECTOR_CRC            (1<<4)
+#define BOOT_CAPS_SET_BAUD              (1<<5)
+#define BOOT_CAPS_FLASH_READ            (1<<6)
+#define BOOT_CAPS_UART_STAT             (1<<7)
+#define BOOT_CAPS_WRITE_END             (1<<8)
+
+#define BOOT_BAUD_DEFAULT               115200
+#define BOOT_BAUD_CONFIRM_TIME          1000    // ms, 부트로더가 새 속도로 패킷을 기다리는 시간
+#define BAUD_RETRY_TIME                 (BOOT_BAUD_CONFIRM_TIME + 500)
+#define SECTOR_LENGTH                   1024
+#define RESP_TIMEOUT                    500     // ms
+#define RETRY_MAX                       5
+#define WINDOW_DEFAULT                  255     // 부트로더가 수신 버퍼 크기에 맞춰 줄여서 허용
+
+#define LZ_HASH_BITS                    15
+#define LZ_CHAIN_MAX                    256
+
+#define DELTA_COPY_MIN                  8
+#define DELTA_HASH_BITS                 16
+#define DELTA_HASH_LENGTH               4
+#define DELTA_CHAIN_MAX                 256
+
+
+using namespace std;
+using clock_type = chrono::steady_clock;
+
+
+typedef struct
+{
+  uint8_t  cmd;
+  uint8_t  err;
+  bool     is_seq;
+  uint8_t  seq;
+  vector<uint8_t> data;
+} packet_t;
+
+typedef struct
+{
+  uint32_t addr;
+  vector<uint8_t> data;
+} write_t;
+
+
+class CmdPort
+{
+  public:
+    bool open(const char *port_name, uint32_t baud);
+    bool setBaud(uint32_t baud);
+    void sendCmd(uint8_t cmd, const uint8_t *p_data, uint32_t length, bool is_seq = false, uint8_t seq = 0);
+    bool receivePacket(packet_t *p_packet, uint32_t timeout);
+    bool sendCmdRxResp(uint8_t cmd, const uint8_t *p_data, uint32_t length, packet_t *p_resp, uint32_t timeout = RESP_TIMEOUT);
+    void flush(void);
+
+  private:
+    int  fd = -1;
+    bool readByte(uint8_t *p_data, uint32_t timeout);
+};
+
+
+static speed_t baudToSpeed(uint32_t baud)
+{
+  switch(baud)
+  {
+    case 9600:    return B9600;
+    case 19200:   return B19200;
+    case 38400:   return B38400;
+    case 57600:   return B57600;
+    case 115200:  return B115200;
+    case 230400:  return B230400;
+    case 460800:  return B460800;
+    case 500000:  return B500000;
+    case 921600:  return B921600;
+    case 1000000: return B1000000;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+  }
+  return B0;
+}
+
+static void putU32(vector<uint8_t> &buf, uint32_t data)
+{
+  buf.push_back((uint8_t)(data >>  0));
+  buf.push_back((uint8_t)(data >>  8));
+  buf.push_back((uint8_t)(data >> 16));
+  buf.push_back((uint8_t)(data >> 24));
+}
+
+static uint32_t getMs(clock_type::time_point time_pre)
+{
+  return (uint32_t)chrono::duration_cast<chrono::milliseconds>(clock_type::now() - time_pre).count();
+}
+
+
+
+
+bool CmdPort::open(const char *port_name, uint32_t baud)
+{
+  struct termios tio;
+
+
+  fd = ::open(port_name, O_RDWR | O_NOCTTY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  if (tcgetattr(fd, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN]  = 0;
+    tio.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+
+  return setBaud(baud);
+}
+
+bool CmdPort::setBaud(uint32_t baud)
+{
+  struct termios tio;
+  speed_t speed;
+
+
+  speed = baudToSpeed(baud);
+  if (speed == B0)
+  {
+    return false;
+  }
+
+  // pty 는 속도 설정이 의미 없으므로 실패해도 진행
+  if (tcgetattr(fd, &tio) == 0)
+  {
+    tcdrain(fd);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+
+  return true;
+}
+
+void CmdPort::flush(void)
+{
+  uint8_t data;
+
+  tcflush(fd, TCIFLUSH);
+  while(readByte(&data, 10) == true);
+}
+
+// cmdSendCmd() 와 같은 형식, is_seq 이면 CMD_STX_SEQ 와 SEQ 를 추가
+//
+void CmdPort::sendCmd(uint8_t cmd, const uint8_t *p_data, uint32_t length, bool is_seq, uint8_t seq)
+{
+  vector<uint8_t> buf;
+  uint8_t check_sum = 0;
+
+
+  if (is_seq == true)
+  {
+    buf.push_back(CMD_STX_SEQ);
+    buf.push_back(seq);
+  }
+  else
+  {
+    buf.push_back(CMD_STX);
+  }
+  buf.push_back(cmd);
+  buf.push_back(CMD_DIR_M_TO_S);
+  buf.push_back(CMD_OK);
+  buf.push_back((uint8_t)(length >> 0));
+  buf.push_back((uint8_t)(length >> 8));
+  buf.insert(buf.end(), p_data, p_data + length);
+
+  for (size_t i=1; i<buf.size(); i++)
+  {
+    check_sum ^= buf[i];
+  }
+  buf.push_back(check_sum);
+  buf.push_back(CMD_ETX);
+
+  size_t index = 0;
+  while(index < buf.size())
+  {
+    ssize_t ret;
+
+    ret = ::write(fd, &buf[index], buf.size() - index);
+    if (ret <= 0)
+    {
+      break;
+    }
+    index += (size_t)ret;
+  }
+}
+
+bool CmdPort::readByte(uint8_t *p_data, uint32_t timeout)
+{
+  fd_set rd_set;
+  struct timeval tv;
+
+
+  FD_ZERO(&rd_set);
+  FD_SET(fd, &rd_set);
+  tv.tv_sec  = timeout / 1000;
+  tv.tv_usec = (timeout % 1000) * 1000;
+
+  if (select(fd + 1, &rd_set, NULL, NULL, &tv) <= 0)
+  {
+    return false;
+  }
+  return (::read(fd, p_data, 1) == 1) ? true:false;
+}
+
+// cmdReceivePacket() 과 같은 순서로 응답 패킷을 받는다.
+//
+bool CmdPort::receivePacket(packet_t *p_packet, uint32_t timeout)
+{
+  auto time_pre = clock_type::now();
+  uint8_t data;
+  uint8_t check_sum;
+  uint8_t header[5];
+  uint16_t length;
+
+
+  while(getMs(time_pre) < timeout)
+  {
+    if (readByte(&data, timeout - getMs(time_pre)) != true)
+    {
+      break;
+    }
+    if (data != CMD_STX && data != CMD_STX_SEQ)
+    {
+      continue;
+    }
+
+    check_sum = 0;
+    p_packet->is_seq = (data == CMD_STX_SEQ);
+    p_packet->seq    = 0;
+
+    if (p_packet->is_seq == true)
+    {
+      if (readByte(&p_packet->seq, 100) != true) continue;
+      check_sum ^= p_packet->seq;
+    }
+
+    bool is_ok = true;
+    for (int i=0; i<5 && is_ok; i++)
+    {
+      is_ok = readByte(&header[i], 100);
+      check_sum ^= header[i];
+    }
+    if (is_ok != true) continue;
+
+    p_packet->cmd = header[0];
+    p_packet->err = header[2];
+    length = (uint16_t)(header[3] | (header[4] << 8));
+
+    p_packet->data.resize(length);
+    for (int i=0; i<length && is_ok; i++)
+    {
+      is_ok = readByte(&p_packet->data[i], 100);
+      check_sum ^= p_packet->data[i];
+    }
+    if (is_ok != true) continue;
+
+    uint8_t check_sum_recv;
+    uint8_t etx;
+
+    if (readByte(&check_sum_recv, 100) != true || readByte(&etx, 100) != true) continue;
+
+    if (etx == CMD_ETX && check_sum == check_sum_recv)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool CmdPort::sendCmdRxResp(uint8_t cmd, const uint8_t *p_data, uint32_t length, packet_t *p_resp, uint32_t timeout)
+{
+  for (int retry=0; retry<RETRY_MAX; retry++)
+  {
+    sendCmd(cmd, p_data, length);
+
+    auto time_pre = clock_type::now();
+    while(getMs(time_pre) < timeout)
+    {
+      if (receivePacket(p_resp, timeout - getMs(time_pre)) != true)
+      {
+        break;
+      }
+      if (p_resp->cmd == cmd)
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+
+
+
+class Uploader
+{
+  public:
+    CmdPort  port;
+    uint32_t caps = 0;
+    uint32_t max_length = 256;
+    uint8_t  window = 0;
+    uint32_t seq_next = 0;      // READ_CAPS 이후 보낸 SEQ 패킷 수
+
+    bool connect(uint8_t window_req);
+    bool changeBaud(uint32_t baud_old, uint32_t baud);
+    bool readSectorCrc(uint32_t addr, uint32_t length, vector<uint16_t> &crc_list);
+    bool read(uint32_t addr, uint32_t length, vector<uint8_t> &buf);
+    bool readUartStat(bool is_clear, vector<uint32_t> &stat);
+    bool erase(uint32_t addr, uint32_t length);
+    bool write(vector<write_t> &write_list);
+    bool writeEnd(void);
+    bool writeCompressed(uint32_t addr, vector<uint8_t> &lz_data);
+    bool writeDelta(uint32_t addr, vector<uint8_t> &old_image, vector<uint8_t> &new_image, vector<uint8_t> &patch, bool *p_is_full);
+    bool jump(void);
+};
+
+
+bool Uploader::connect(uint8_t window_req)
+{
+  packet_t resp;
+  uint8_t  data[1];
+
+
+  port.flush();
+  if (port.sendCmdRxResp(BOOT_CMD_READ_BOOT_VERSION, NULL, 0, &resp) != true)
+  {
+    printf("no response\n");
+    return false;
+  }
+  printf("boot version  : %.32s\n", (char *)resp.data.data());
+
+  if (port.sendCmdRxResp(BOOT_CMD_READ_BOOT_NAME, NULL, 0, &resp) == true)
+  {
+    printf("boot name     : %.32s\n", (char *)resp.data.data());
+  }
+
+  // 이전 부트로더는 READ_CAPS 를 모르므로 기본 값으로 진행
+  data[0] = window_req;
+  if (port.sendCmdRxResp(BOOT_CMD_READ_CAPS, data, 1, &resp) == true &&
+      resp.err == CMD_OK && resp.data.size() >= 7)
+  {
+    caps       = resp.data[0] | (resp.data[1] << 8) | (resp.data[2] << 16) | ((uint32_t)resp.data[3] << 24);
+    window     = resp.data[4];
+    max_length = resp.data[5] | (resp.data[6] << 8);
+  }
+  if ((caps & BOOT_CAPS_WINDOW) == 0)
+  {
+    window = 0;
+  }
+  printf("boot caps     : 0x%08X, window %d, max length %d\n", caps, window, max_length);
+
+  return true;
+}
+
+bool Uploader::changeBaud(uint32_t baud_old, uint32_t baud)
+{
+  packet_t resp;
+  vector<uint8_t> data;
+
+
+  if ((caps & BOOT_CAPS_SET_BAUD) == 0 || baudToSpeed(baud) == B0)
+  {
+    printf("set baud      : not supported, %d\n", baud_old);
+    return false;
+  }
+
+  putU32(data, baud);
+  if (port.sendCmdRxResp(BOOT_CMD_SET_BAUD, data.data(), data.size(), &resp) != true || resp.err != CMD_OK)
+  {
+    printf("set baud      : %d fail, %d\n", baud, baud_old);
+    return false;
+  }
+
+  // 새 속도에서 응답이 있으면 완료, 아니면 부트로더와 같이 이전 속도로 복귀.
+  // 부트로더는 새 속도로 패킷을 하나라도 받으면 새 속도로 확정하므로,
+  // 응답만 잃어버린 경우에도 어긋나지 않도록 부트로더의 대기 시간보다 길게 새 속도로 다시 보낸다.
+  //
+  auto time_pre = clock_type::now();
+
+  port.setBaud(baud);
+  usleep(10*1000);
+  port.flush();
+  while(getMs(time_pre) < BAUD_RETRY_TIME)
+  {
+    port.sendCmd(BOOT_CMD_READ_BOOT_VERSION, NULL, 0);
+    if (port.receivePacket(&resp, 200) == true && resp.cmd == BOOT_CMD_READ_BOOT_VERSION)
+    {
+      printf("set baud      : %d\n", baud);
+      return true;
+    }
+  }
+
+  // 이 때는 부트로더도 이미 이전 속도로 돌아가 있다.
+  port.setBaud(baud_old);
+  usleep(10*1000);
+  port.flush();
+  printf("set baud      : %d no response, %d\n", baud, baud_old);
+  return false;
+}
+
+bool Uploader::readSectorCrc(uint32_t addr, uint32_t length, vector<uint16_t> &crc_list)
+{
+  packet_t resp;
+  uint32_t sector_max;
+
+
+  if ((caps & BOOT_CAPS_SECTOR_CRC) == 0)
+  {
+    return false;
+  }
+
+  crc_list.clear();
+  sector_max = max_length / 2;
+
+  while(length > 0)
+  {
+    vector<uint8_t> data;
+    uint32_t read_len;
+
+    read_len = min(length, sector_max * SECTOR_LENGTH);
+    putU32(data, addr);
+    putU32(data, read_len);
+
+    if (port.sendCmdRxResp(BOOT_CMD_FLASH_READ_CRC, data.data(), data.size(), &resp) != true || resp.err != CMD_OK)
+    {
+      return false;
+    }
+    for (size_t i=0; i+1<resp.data.size(); i+=2)
+    {
+      crc_list.push_back((uint16_t)(resp.data[i] | (resp.data[i+1] << 8)));
+    }
+
+    addr   += read_len;
+    length -= read_len;
+  }
+
+  return true;
+}
+
+// 응답 데이터 뒤의 CRC16 이 맞지 않으면 같은 주소를 다시 읽는다.
+//
+bool Uploader::read(uint32_t addr, uint32_t length, vector<uint8_t> &buf)
+{
+  packet_t resp;
+  uint32_t chunk_max;
+
+
+  if ((caps & BOOT_CAPS_FLASH_READ) == 0)
+  {
+    printf("read          : not supported\n");
+    return false;
+  }
+
+  crcInit();
+  buf.clear();
+  chunk_max = max_length - 2;
+
+  while(length > 0)
+  {
+    vector<uint8_t> data;
+    uint32_t read_len;
+    uint16_t crc;
+    int      retry;
+
+    read_len = min(length, chunk_max);
+    putU32(data, addr);
+    putU32(data, read_len);
+
+    for (retry=0; retry<RETRY_MAX; retry++)
+    {
+      if (port.sendCmdRxResp(BOOT_CMD_FLASH_READ, data.data(), data.size(), &resp) != true || resp.err != CMD_OK)
+      {
+        printf("read fail     : 0x%X, err 0x%02X\n", addr, resp.err);
+        return false;
+      }
+      if (resp.data.size() != read_len + 2)
+      {
+        continue;
+      }
+
+      crc = 0;
+      crcUpdate(&crc, resp.data.data(), read_len);
+      if (crc == (uint16_t)(resp.data[read_len] | (resp.data[read_len + 1] << 8)))
+      {
+        break;
+      }
+    }
+    if (retry >= RETRY_MAX)
+    {
+      printf("read fail     : 0x%X, crc\n", addr);
+      return false;
+    }
+
+    buf.insert(buf.end(), resp.data.begin(), resp.data.begin() + read_len);
+    addr   += read_len;
+    length -= read_len;
+  }
+
+  return true;
+}
+
+// rx drop, overrun, parity err, frame err, rx peak 순서.
+//
+bool Uploader::readUartStat(bool is_clear, vector<uint32_t> &stat)
+{
+  packet_t resp;
+  uint8_t  data[1];
+
+
+  if ((caps & BOOT_CAPS_UART_STAT) == 0)
+  {
+    return false;
+  }
+
+  data[0] = is_clear ? 1:0;
+  if (port.sendCmdRxResp(BOOT_CMD_READ_UART_STAT, data, 1, &resp) != true || resp.err != CMD_OK || resp.data.size() < 20)
+  {
+    return false;
+  }
+
+  stat.clear();
+  for (size_t i=0; i<20; i+=4)
+  {
+    stat.push_back(resp.data[i] | (resp.data[i+1] << 8) | (resp.data[i+2] << 16) | ((uint32_t)resp.data[i+3] << 24));
+  }
+  return true;
+}
+
+bool Uploader::erase(uint32_t addr, uint32_t length)
+{
+  packet_t resp;
+  vector<uint8_t> data;
+
+
+  putU32(data, addr);
+  putU32(data, length);
+
+  if (port.sendCmdRxResp(BOOT_CMD_FLASH_ERASE, data.data(), data.size(), &resp, 10*1000) != true || resp.err != CMD_OK)
+  {
+    printf("erase fail    : 0x%X, err 0x%02X\n", addr, resp.err);
+    return false;
+  }
+  return true;
+}
+
+// Window 크기만큼 응답을 기다리지 않고 보내고, 응답의 base/bits 로 받은 패킷을 확인한다.
+//
+bool Uploader::write(vector<write_t> &write_list)
+{
+  vector<vector<uint8_t>> pkt_list;
+  vector<bool> acked;
+  size_t   base = 0;
+  size_t   next = 0;
+  uint8_t  seq_offset = (uint8_t)seq_next;
+  uint32_t window_size;
+  int      retry = 0;
+  packet_t resp;
+
+
+  for (auto &w : write_list)
+  {
+    vector<uint8_t> data;
+
+    putU32(data, w.addr);
+    putU32(data, (uint32_t)w.data.size());
+    data.insert(data.end(), w.data.begin(), w.data.end());
+    pkt_list.push_back(data);
+  }
+  acked.resize(pkt_list.size(), false);
+
+  if (window == 0)
+  {
+    for (auto &pkt : pkt_list)
+    {
+      if (port.sendCmdRxResp(BOOT_CMD_FLASH_WRITE, pkt.data(), pkt.size(), &resp) != true || resp.err != CMD_OK)
+      {
+        printf("write fail    : err 0x%02X\n", resp.err);
+        return false;
+      }
+    }
+    return writeEnd();
+  }
+
+  window_size = window;
+
+  while(base < pkt_list.size())
+  {
+    while(next < pkt_list.size() && next - base < window_size)
+    {
+      port.sendCmd(BOOT_CMD_FLASH_WRITE, pkt_list[next].data(), pkt_list[next].size(), true, (uint8_t)(seq_offset + next));
+      next++;
+    }
+
+    if (port.receivePacket(&resp, RESP_TIMEOUT) != true)
+    {
+      // 응답이 없으면 아직 받지 못한 패킷을 다시 보낸다.
+      if (++retry > RETRY_MAX)
+      {
+        printf("write fail    : timeout\n");
+        return false;
+      }
+      for (size_t i=base; i<next; i++)
+      {
+        if (acked[i] != true)
+        {
+          port.sendCmd(BOOT_CMD_FLASH_WRITE, pkt_list[i].data(), pkt_list[i].size(), true, (uint8_t)(seq_offset + i));
+        }
+      }
+      continue;
+    }
+
+    if (resp.cmd != BOOT_CMD_FLASH_WRITE || resp.data.size() < 5)
+    {
+      continue;
+    }
+    if (resp.err != CMD_OK && resp.err != BOOT_ERR_WRONG_SEQ)
+    {
+      printf("write fail    : seq %d, err 0x%02X\n", resp.seq, resp.err);
+      return false;
+    }
+    retry = 0;
+
+    uint8_t  dev_base = resp.data[0];
+    uint32_t dev_bits = resp.data[1] | (resp.data[2] << 8) | (resp.data[3] << 16) | ((uint32_t)resp.data[4] << 24);
+    size_t   offset   = (uint8_t)(dev_base - (uint8_t)(seq_offset + base));
+
+    if (offset <= next - base)
+    {
+      for (size_t i=0; i<offset; i++)
+      {
+        acked[base + i] = true;
+      }
+      base += offset;
+      for (size_t i=0; i<32 && base + i < next; i++)
+      {
+        if (dev_bits & (1U<<i))
+        {
+          acked[base + i] = true;
+        }
+      }
+    }
+  }
+
+  seq_next += (uint32_t)pkt_list.size();
+
+  // 남은 응답을 비운다.
+  while(port.receivePacket(&resp, 20) == true);
+
+  return writeEnd();
+}
+
+// 응답을 먼저 보내고 Write 하므로, Write 에러는 마지막에 길이 0 패킷으로 실패한 주소와 같이 받는다.
+//
+bool Uploader::writeEnd(void)
+{
+  packet_t resp;
+  vector<uint8_t> data;
+
+
+  if ((caps & BOOT_CAPS_WRITE_END) == 0)
+  {
+    return true;
+  }
+
+  putU32(data, 0);
+  putU32(data, 0);
+  if (port.sendCmdRxResp(BOOT_CMD_FLASH_WRITE, data.data(), data.size(), &resp) != true)
+  {
+    printf("write fail    : timeout\n");
+    return false;
+  }
+  if (resp.err != CMD_OK)
+  {
+    if (resp.data.size() >= 4)
+    {
+      printf("write fail    : 0x%X, err 0x%02X\n",
+             resp.data[0] | (resp.data[1] << 8) | (resp.data[2] << 16) | ((uint32_t)resp.data[3] << 24), resp.err);
+    }
+    else
+    {
+      printf("write fail    : err 0x%02X\n", resp.err);
+    }
+    return false;
+  }
+  return true;
+}
+
+// addr 은 압축 해제 데이터의 시작 주소로 스트림 동안 같은 값, 마지막에 길이 0 으로 스트림을 끝낸다.
+// 부트로더가 압축을 풀면서 Write 하므로 패킷마다 응답을 기다린다.
+//
+bool Uploader::writeCompressed(uint32_t addr, vector<uint8_t> &lz_data)
+{
+  packet_t resp;
+  uint32_t chunk_max;
+  uint32_t index = 0;
+
+
+  if ((caps & BOOT_CAPS_COMPRESS) == 0)
+  {
+    printf("write         : compress not supported\n");
+    return false;
+  }
+
+  chunk_max = max_length - 8;
+
+  while(true)
+  {
+    vector<uint8_t> data;
+    uint32_t len;
+
+    len = min((uint32_t)lz_data.size() - index, chunk_max);
+    putU32(data, addr);
+    putU32(data, len);
+    data.insert(data.end(), lz_data.begin() + index, lz_data.begin() + index + len);
+
+    if (port.sendCmdRxResp(BOOT_CMD_FLASH_WRITE_COMPRESSED, data.data(), data.size(), &resp) != true || resp.err != CMD_OK)
+    {
+      printf("write fail    : 0x%X, lz %d, err 0x%02X\n", addr, index, resp.err);
+      return false;
+    }
+
+    if (len == 0)
+    {
+      break;
+    }
+    index += len;
+  }
+
+  return true;
+}
+
+// 부트로더가 섹터 단위로 패치를 적용하면서 Erase/Write 하고, 태그의 magic 은 DELTA_END 에서 Write 한다.
+// 패치를 지원하지 않거나 설치된 이미지가 old_image 와 달라서 전체 업로드를 해야 하면 *p_is_full 을 true 로 한다.
+//
+bool Uploader::writeDelta(uint32_t addr, vector<uint8_t> &old_image, vector<uint8_t> &new_image, vector<uint8_t> &patch, bool *p_is_full)
+{
+  packet_t resp;
+  vector<uint8_t> data;
+  uint16_t crc = 0;
+  uint32_t chunk_max;
+  uint32_t index = 0;
+
+
+  *p_is_full = false;
+
+  if ((caps & BOOT_CAPS_DELTA) == 0)
+  {
+    printf("delta         : not supported\n");
+    *p_is_full = true;
+    return false;
+  }
+
+  crcInit();
+  crcUpdate(&crc, old_image.data(), (uint32_t)old_image.size());
+
+  putU32(data, addr);
+  putU32(data, (uint32_t)new_image.size());
+  putU32(data, (uint32_t)old_image.size());
+  data.push_back((uint8_t)(crc >> 0));
+  data.push_back((uint8_t)(crc >> 8));
+
+  if (port.sendCmdRxResp(BOOT_CMD_DELTA_BEGIN, data.data(), data.size(), &resp) != true || resp.err != CMD_OK)
+  {
+    *p_is_full = (resp.err == BOOT_ERR_DELTA_BASE);
+    if (*p_is_full == true)
+    {
+      printf("delta         : installed image differs\n");
+    }
+    else
+    {
+      printf("delta fail    : begin, err 0x%02X\n", resp.err);
+    }
+    return false;
+  }
+
+  chunk_max = max_length - 8;
+
+  while(index < patch.size())
+  {
+    uint32_t len;
+
+    len = min((uint32_t)patch.size() - index, chunk_max);
+    data.clear();
+    putU32(data, addr);
+    putU32(data, len);
+    data.insert(data.end(), patch.begin() + index, patch.begin() + index + len);
+
+    // 섹터 Erase 가 들어가므로 응답 대기를 길게
+    if (port.sendCmdRxResp(BOOT_CMD_DELTA_WRITE, data.data(), data.size(), &resp, 5*1000) != true || resp.err != CMD_OK)
+    {
+      printf("delta fail    : patch %d, err 0x%02X\n", index, resp.err);
+      return false;
+    }
+    index += len;
+  }
+
+  if (port.sendCmdRxResp(BOOT_CMD_DELTA_END, NULL, 0, &resp, 5*1000) != true || resp.err != CMD_OK)
+  {
+    printf("delta fail    : end, err 0x%02X\n", resp.err);
+    return false;
+  }
+
+  return true;
+}
+
+bool Uploader::jump(void)
+{
+  packet_t resp;
+
+  if (port.sendCmdRxResp(BOOT_CMD_JUMP_TO_FW, NULL, 0, &resp, 5*1000) != true || resp.err != CMD_OK)
+  {
+    printf("jump fail     : err 0x%02X\n", resp.err);
+    return false;
+  }
+  return true;
+}
+
+
+
+
+static bool readFile(const char *name, vector<uint8_t> &buf)
+{
+  FILE *fp;
+  long  size;
+
+  fp = fopen(name, "rb");
+  if (fp == NULL)
+  {
+    return false;
+  }
+  fseek(fp, 0, SEEK_END);
+  size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+
+  buf.resize(size > 0 ? size : 0);
+  bool ret = (fread(buf.data(), 1, buf.size(), fp) == buf.size());
+  fclose(fp);
+
+  return ret;
+}
+
+// 태그의 magic, 펌웨어 영역, CRC 를 채운다. (bootVerifyCrc() 와 같은 방식)
+//
+static bool fillTag(vector<uint8_t> &image, uint32_t addr)
+{
+  firm_tag_t tag;
+  uint16_t crc = 0;
+  time_t   t;
+
+
+  if (image.size() <= SECTOR_LENGTH)
+  {
+    return false;
+  }
+
+  memcpy(&tag, image.data(), sizeof(tag));
+
+  tag.magic_number     = FLASH_MAGIC_NUMBER;
+  tag.addr_tag         = addr;
+  tag.size_tag         = SECTOR_LENGTH;
+  tag.tag_flash_type   = 0;
+  tag.tag_flash_start  = addr + SECTOR_LENGTH;
+  tag.tag_flash_length = (uint32_t)image.size() - SECTOR_LENGTH;
+  tag.tag_flash_end    = tag.tag_flash_start + tag.tag_flash_length;
+  tag.tag_length       = sizeof(tag);
+
+  crcInit();
+  crcUpdate(&crc, &image[SECTOR_LENGTH], tag.tag_flash_length);
+  tag.tag_flash_crc = crc;
+
+  t = time(NULL);
+  memset(tag.tag_date_str, 0, sizeof(tag.tag_date_str));
+  memset(tag.tag_time_str, 0, sizeof(tag.tag_time_str));
+  strftime((char *)tag.tag_date_str, sizeof(tag.tag_date_str), "%Y-%m-%d", localtime(&t));
+  strftime((char *)tag.tag_time_str, sizeof(tag.tag_time_str), "%H:%M:%S", localtime(&t));
+
+  memcpy(image.data(), &tag, sizeof(tag));
+
+  printf("fw            : 0x%X, %d bytes, crc 0x%04X\n", tag.tag_flash_start, tag.tag_flash_length, crc);
+  return true;
+}
+
+static void addSector(vector<write_t> &write_list, vector<uint8_t> &image, uint32_t addr_base, uint32_t offset, uint32_t chunk_max)
+{
+  uint32_t end;
+
+  end = min((uint32_t)image.size(), offset + SECTOR_LENGTH);
+  while(offset < end)
+  {
+    write_t w;
+    uint32_t len;
+
+    len = min(end - offset, chunk_max);
+    w.addr = addr_base + offset;
+    w.data.assign(image.begin() + offset, image.begin() + offset + len);
+    while(w.data.size()%4 != 0)
+    {
+      w.data.push_back(0xFF);
+    }
+    write_list.push_back(w);
+    offset += len;
+  }
+}
+
+static uint32_t lzHash(const uint8_t *p)
+{
+  return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761U) >> (32 - LZ_HASH_BITS);
+}
+
+static void lzLiteral(vector<uint8_t> &out, const uint8_t *p_src, uint32_t begin, uint32_t end)
+{
+  while(begin < end)
+  {
+    uint32_t count;
+
+    count = min(end - begin, (uint32_t)LZ_LITERAL_MAX);
+
+    out.push_back((uint8_t)(count - 1));
+    out.insert(out.end(), p_src + begin, p_src + begin + count);
+    begin += count;
+  }
+}
+
+// tools/lzpack 의 compress() 와 같은 인코더. (hash chain, 겹치는 복사 허용)
+//
+static void lzCompress(const vector<uint8_t> &src, vector<uint8_t> &out)
+{
+  const uint8_t  *p_src  = src.data();
+  uint32_t        length = (uint32_t)src.size();
+  uint32_t        pos = 0;
+  uint32_t        lit_begin = 0;
+  vector<int32_t> hash_head(1<<LZ_HASH_BITS, -1);
+  vector<int32_t> hash_prev(length + 1, -1);
+
+  auto hashAdd = [&](uint32_t p)
+  {
+    if (p + LZ_MATCH_MIN <= length)
+    {
+      uint32_t h = lzHash(&p_src[p]);
+      hash_prev[p] = hash_head[h];
+      hash_head[h] = p;
+    }
+  };
+
+
+  out.clear();
+
+  while(pos < length)
+  {
+    uint32_t best_len = 0;
+    uint32_t best_off = 0;
+
+    if (pos + LZ_MATCH_MIN <= length)
+    {
+      int32_t cand  = hash_head[lzHash(&p_src[pos])];
+      int     chain = 0;
+
+      while(cand >= 0 && pos - cand <= LZ_OFFSET_MAX && chain++ < LZ_CHAIN_MAX)
+      {
+        uint32_t len = 0;
+        uint32_t len_max = min(length - pos, (uint32_t)LZ_MATCH_MAX);
+
+        while(len < len_max && p_src[cand + len] == p_src[pos + len])
+        {
+          len++;
+        }
+        if (len > best_len)
+        {
+          best_len = len;
+          best_off = pos - cand;
+          if (len == len_max) break;
+        }
+        cand = hash_prev[cand];
+      }
+    }
+
+    if (best_len >= LZ_MATCH_MIN)
+    {
+      lzLiteral(out, p_src, lit_begin, pos);
+
+      out.push_back((uint8_t)(LZ_TOKEN_MATCH | (best_len - LZ_MATCH_MIN)));
+      out.push_back((uint8_t)(best_off >> 0));
+      out.push_back((uint8_t)(best_off >> 8));
+
+      for (uint32_t i=0; i<best_len; i++)
+      {
+        hashAdd(pos++);
+      }
+      lit_begin = pos;
+    }
+    else
+    {
+      hashAdd(pos++);
+    }
+  }
+  lzLiteral(out, p_src, lit_begin, pos);
+}
+
+static uint32_t deltaHash(const uint8_t *p)
+{
+  return ((uint32_t)(p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]) * 2654435761U) >> (32 - DELTA_HASH_BITS);
+}
+
+// new[pos] 부터 old[src] 와 같은 길이, 덮어쓴 섹터는 참조하지 않는다.
+//
+static uint32_t deltaMatchLength(const vector<uint8_t> &old_image, const vector<uint8_t> &new_image, uint32_t src, uint32_t pos)
+{
+  uint32_t len = 0;
+
+  while(pos + len < new_image.size() &&
+        src + len < old_image.size() &&
+        len < DELTA_COPY_MAX &&
+        src + len >= (pos + len) - ((pos + len) % SECTOR_LENGTH) &&
+        old_image[src + len] == new_image[pos + len])
+  {
+    len++;
+  }
+
+  return len;
+}
+
+static void deltaInsert(vector<uint8_t> &out, const vector<uint8_t> &new_image, uint32_t begin, uint32_t end)
+{
+  while(begin < end)
+  {
+    uint32_t count;
+
+    count = min(end - begin, (uint32_t)DELTA_INSERT_MAX);
+
+    out.push_back((uint8_t)(count - 1));
+    out.insert(out.end(), new_image.begin() + begin, new_image.begin() + begin + count);
+    begin += count;
+  }
+}
+
+// tools/deltagen 의 generate() 와 같은 인코더.
+//
+static void deltaGenerate(const vector<uint8_t> &old_image, const vector<uint8_t> &new_image, vector<uint8_t> &out)
+{
+  uint32_t        old_len = (uint32_t)old_image.size();
+  uint32_t        new_len = (uint32_t)new_image.size();
+  uint32_t        pos = 0;
+  uint32_t        ins_begin = 0;
+  vector<int32_t> hash_head(1<<DELTA_HASH_BITS, -1);
+  vector<int32_t> hash_prev(old_len + 1, -1);
+
+
+  out.clear();
+
+  for (uint32_t i=0; i + DELTA_HASH_LENGTH <= old_len; i++)
+  {
+    uint32_t h = deltaHash(&old_image[i]);
+    hash_prev[i] = hash_head[h];
+    hash_head[h] = i;
+  }
+
+  while(pos < new_len)
+  {
+    uint32_t best_len = 0;
+    uint32_t best_src = 0;
+
+    // 같은 위치를 먼저 확인 (변경되지 않은 영역)
+    if (pos < old_len)
+    {
+      best_len = deltaMatchLength(old_image, new_image, pos, pos);
+      best_src = pos;
+    }
+
+    if (best_len < DELTA_COPY_MAX && pos + DELTA_HASH_LENGTH <= new_len)
+    {
+      int32_t cand  = hash_head[deltaHash(&new_image[pos])];
+      int     chain = 0;
+
+      while(cand >= 0 && chain++ < DELTA_CHAIN_MAX)
+      {
+        uint32_t len;
+
+        len = deltaMatchLength(old_image, new_image, (uint32_t)cand, pos);
+        if (len > best_len)
+        {
+          best_len = len;
+          best_src = (uint32_t)cand;
+        }
+        cand = hash_prev[cand];
+      }
+    }
+
+    if (best_len >= DELTA_COPY_MIN)
+    {
+      deltaInsert(out, new_image, ins_begin, pos);
+
+      out.push_back(DELTA_TOKEN_COPY);
+      out.push_back((uint8_t)(best_src >>  0));
+      out.push_back((uint8_t)(best_src >>  8));
+      out.push_back((uint8_t)(best_src >> 16));
+      out.push_back((uint8_t)(best_len >>  0));
+      out.push_back((uint8_t)(best_len >>  8));
+
+      pos += best_len;
+      ins_begin = pos;
+    }
+    else
+    {
+      pos++;
+    }
+  }
+  deltaInsert(out, new_image, ins_begin, pos);
+}
+
+int main(int argc, char *argv[])
+{
+  const char *port_name = NULL;
+  const char *file_name = NULL;
+  const char *old_name  = NULL;
+  uint32_t baud      = BOOT_BAUD_DEFAULT;
+  uint32_t addr      = 0x8000;
+  int      window    = WINDOW_DEFAULT;
+  bool     is_full   = false;
+  bool     is_jump   = true;
+  bool     is_lz     = false;
+  uint32_t read_len  = 0;
+  int      opt;
+
+  vector<uint8_t>  image;
+  vector<uint16_t> crc_dev;
+  vector<bool>     is_diff;
+  vector<write_t>  write_list;
+  vector<uint32_t> uart_stat;
+  uint32_t         sector_cnt;
+  uint32_t         diff_cnt = 0;
+  uint32_t         chunk_max;
+  uint32_t         lz_total = 0;
+
+  auto time_total = clock_type::now();
+  auto time_pre   = clock_type::now();
+
+
+  while((opt = getopt(argc, argv, "p:b:w:a:fnr:zd:")) != -1)
+  {
+    switch(opt)
+    {
+      case 'p': port_name = optarg; break;
+      case 'b': baud      = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'w': window    = atoi(optarg); break;
+      case 'a': addr      = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'f': is_full   = true; break;
+      case 'n': is_jump   = false; break;
+      case 'r': read_len  = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'z': is_lz     = true; break;
+      case 'd': old_name  = optarg; break;
+      default:
+        break;
+    }
+  }
+  if (optind < argc)
+  {
+    file_name = argv[optind];
+  }
+  if (port_name == NULL || file_name == NULL)
+  {
+    printf("uploader -p port [-b baud] [-w window] [-a addr] [-f] [-n] [-z] [-d old.bin] firmware.bin\n");
+    printf("uploader -p port [-b baud] [-a addr] -r length dump.bin\n");
+    return 1;
+  }
+
+  if (read_len == 0 && (readFile(file_name, image) != true || fillTag(image, addr) != true))
+  {
+    printf("read fail : %s\n", file_name);
+    return 1;
+  }
+
+  Uploader up;
+
+  if (up.port.open(port_name, BOOT_BAUD_DEFAULT) != true)
+  {
+    printf("open fail : %s\n", port_name);
+    return 1;
+  }
+  if (up.connect((uint8_t)min(max(window, 0), 255)) != true)
+  {
+    return 1;
+  }
+  if (baud != BOOT_BAUD_DEFAULT)
+  {
+    up.changeBaud(BOOT_BAUD_DEFAULT, baud);
+  }
+  printf("connect       : %d ms\n", getMs(time_pre));
+
+  // 속도 변경 중에 생긴 오류는 빼고 업로드 중의 Drop 만 확인
+  up.readUartStat(true, uart_stat);
+
+
+  //-- Read
+  //
+  if (read_len > 0)
+  {
+    FILE *fp;
+
+    time_pre = clock_type::now();
+    if (up.read(addr, read_len, image) != true)
+    {
+      return 1;
+    }
+    printf("read          : %d ms, %d bytes\n", getMs(time_pre), read_len);
+
+    fp = fopen(file_name, "wb");
+    if (fp == NULL || fwrite(image.data(), 1, image.size(), fp) != image.size())
+    {
+      printf("write fail : %s\n", file_name);
+      return 1;
+    }
+    fclose(fp);
+    return 0;
+  }
+
+
+  //-- Delta, 패치가 끝나면 아래 섹터 비교에서 바뀐 섹터가 없어야 한다.
+  //
+  if (old_name != NULL)
+  {
+    vector<uint8_t> old_image;
+    vector<uint8_t> new_image = image;
+    vector<uint8_t> tag;
+    vector<uint8_t> patch;
+    bool is_full_upload;
+
+    time_pre = clock_type::now();
+    if (readFile(old_name, old_image) != true || old_image.size() <= SECTOR_LENGTH)
+    {
+      printf("read fail : %s\n", old_name);
+      return 1;
+    }
+
+    // 설치된 태그 섹터에는 그 때의 업로드 시각이 들어 있으므로 보드에서 읽어서 사용
+    if (up.read(addr, SECTOR_LENGTH, tag) == true)
+    {
+      memcpy(old_image.data(), tag.data(), SECTOR_LENGTH);
+    }
+
+    // Write 와 같이 4바이트 단위로 0xFF 를 채운다.
+    while(old_image.size()%4 != 0)
+    {
+      old_image.push_back(0xFF);
+    }
+    while(new_image.size()%4 != 0)
+    {
+      new_image.push_back(0xFF);
+    }
+
+    deltaGenerate(old_image, new_image, patch);
+
+    if (up.writeDelta(addr, old_image, new_image, patch, &is_full_upload) == true)
+    {
+      printf("delta         : %d ms, %d bytes, patch %d bytes\n", getMs(time_pre), (uint32_t)new_image.size(), (uint32_t)patch.size());
+    }
+    else if (is_full_upload == true)
+    {
+      printf("delta         : full upload\n");
+    }
+    else
+    {
+      return 1;
+    }
+  }
+
+
+  //-- 섹터 비교
+  //
+  time_pre   = clock_type::now();
+  sector_cnt = ((uint32_t)image.size() + SECTOR_LENGTH - 1) / SECTOR_LENGTH;
+  is_diff.resize(sector_cnt, true);
+
+  if (is_full != true && up.readSectorCrc(addr, sector_cnt * SECTOR_LENGTH, crc_dev) == true && crc_dev.size() == sector_cnt)
+  {
+    for (uint32_t i=0; i<sector_cnt; i++)
+    {
+      vector<uint8_t> sector(SECTOR_LENGTH, 0xFF);
+      uint16_t crc = 0;
+      uint32_t len = min((uint32_t)image.size() - i*SECTOR_LENGTH, (uint32_t)SECTOR_LENGTH);
+
+      memcpy(sector.data(), &image[i*SECTOR_LENGTH], len);
+      crcUpdate(&crc, sector.data(), SECTOR_LENGTH);
+      is_diff[i] = (crc != crc_dev[i]);
+    }
+  }
+  for (uint32_t i=0; i<sector_cnt; i++)
+  {
+    diff_cnt += is_diff[i] ? 1:0;
+  }
+  printf("compare       : %d ms, %d/%d sectors changed\n", getMs(time_pre), diff_cnt, sector_cnt);
+
+
+  //-- Erase, 연속으로 바뀐 섹터는 한번에 Erase
+  //
+  time_pre = clock_type::now();
+  for (uint32_t i=0; i<sector_cnt; )
+  {
+    uint32_t cnt = 0;
+
+    while(i + cnt < sector_cnt && is_diff[i + cnt] == true)
+    {
+      cnt++;
+    }
+    if (cnt > 0 && up.erase(addr + i*SECTOR_LENGTH, cnt*SECTOR_LENGTH) != true)
+    {
+      return 1;
+    }
+    i += max(cnt, 1U);
+  }
+  printf("erase         : %d ms\n", getMs(time_pre));
+
+
+  //-- Write, 태그 섹터는 마지막에 Write
+  //
+  time_pre  = clock_type::now();
+  chunk_max = (up.max_length - 8) & ~0x03;
+  if (is_lz == true)
+  {
+    // 연속으로 바뀐 섹터를 하나의 스트림으로 압축
+    //
+    for (uint32_t i=1; i<sector_cnt; )
+    {
+      vector<uint8_t> run;
+      vector<uint8_t> lz_data;
+      uint32_t cnt = 0;
+
+      while(i + cnt < sector_cnt && is_diff[i + cnt] == true)
+      {
+        cnt++;
+      }
+      if (cnt > 0)
+      {
+        run.assign(image.begin() + i*SECTOR_LENGTH, image.begin() + min((uint32_t)image.size(), (i + cnt)*SECTOR_LENGTH));
+        while(run.size()%4 != 0)
+        {
+          run.push_back(0xFF);
+        }
+        lzCompress(run, lz_data);
+        lz_total += (uint32_t)lz_data.size();
+
+        if (up.writeCompressed(addr + i*SECTOR_LENGTH, lz_data) != true)
+        {
+          return 1;
+        }
+      }
+      i += max(cnt, 1U);
+    }
+  }
+  else
+  {
+    for (uint32_t i=1; i<sector_cnt; i++)
+    {
+      if (is_diff[i] == true)
+      {
+        addSector(write_list, image, addr, i*SECTOR_LENGTH, chunk_max);
+      }
+    }
+    if (up.write(write_list) != true)
+    {
+      return 1;
+    }
+  }
+  write_list.clear();
+  if (is_diff[0] == true)
+  {
+    addSector(write_list, image, addr, 0, chunk_max);
+    if (up.write(write_list) != true)
+    {
+      return 1;
+    }
+  }
+  if (is_lz == true)
+  {
+    printf("write         : %d ms, %d bytes, lz %d bytes\n", getMs(time_pre), diff_cnt * SECTOR_LENGTH, lz_total);
+  }
+  else
+  {
+    printf("write         : %d ms, %d bytes\n", getMs(time_pre), diff_cnt * SECTOR_LENGTH);
+  }
+
+
+  //-- Verify
+  //
+  time_pre = clock_type::now();
+  if (up.readSectorCrc(addr, sector_cnt * SECTOR_LENGTH, crc_dev) == true)
+  {
+    for (uint32_t i=0; i<sector_cnt; i++)
+    {
+      vector<uint8_t> sector(SECTOR_LENGTH, 0xFF);
+      uint16_t crc = 0;
+      uint32_t len = min((uint32_t)image.size() - i*SECTOR_LENGTH, (uint32_t)SECTOR_LENGTH);
+
+      memcpy(sector.data(), &image[i*SECTOR_LENGTH], len);
+      crcUpdate(&crc, sector.data(), SECTOR_LENGTH);
+      if (i >= crc_dev.size() || crc != crc_dev[i])
+      {
+        printf("verify fail   : sector 0x%X\n", addr + i*SECTOR_LENGTH);
+        return 1;
+      }
+    }
+    printf("verify        : %d ms\n", getMs(time_pre));
+  }
+  else
+  {
+    printf("verify        : skip (no sector crc)\n");
+  }
+
+  if (up.readUartStat(false, uart_stat) == true && (uart_stat[0] > 0 || uart_stat[1] > 0))
+  {
+    printf("warning       : rx drop %d, overrun %d, rx peak %d (lower -w or -b)\n", uart_stat[0], uart_stat[1], uart_stat[4]);
+  }
+
+
+  //-- Jump
+  //
+  if (is_jump == true)
+  {
+    time_pre = clock_type::now();
+    if (up.jump() != true)
+    {
+      return 1;
+    }
+    printf("jump          : %d ms\n", getMs(time_pre));
+  }
+
+  printf("total         : %d ms\n", getMs(time_total));
+
+  return 0;
+}